@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/chrono.hpp>
+
+
+/**
+*   ""  .
+*
+*      (ns/op),  
+*  (allocs/op)     (bytes/op)   .
+*      operator new / delete,
+*   bench.cpp.
+*/
+
+
+// VC10   thread_local
+#ifdef _MSC_VER
+    #define BENCH_THREAD_LOCAL __declspec( thread )
+#else
+    #define BENCH_THREAD_LOCAL __thread
+#endif
+
+
+namespace bench {
+
+/**
+*   .    - :   
+*   ,  .  FakeCouchDB,
+* curl      .
+*/
+extern BENCH_THREAD_LOCAL std::size_t allocCount;
+extern BENCH_THREAD_LOCAL std::size_t allocBytes;
+
+
+
+/**
+*    .
+*/
+struct Result {
+    std::string name;
+    std::size_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+
+
+/**
+*  'fn'   ,    'minTime'  
+*   'minIterations' .
+*
+* @param fn   .   .
+*/
+template< typename F >
+inline Result run(
+    const std::string& name,
+    F fn,
+    std::size_t minTime = 500,
+    std::size_t minIterations = 10
+) {
+    typedef boost::chrono::steady_clock  clock_t;
+
+    // :  ,    ..
+    fn();
+
+    std::size_t iterations = 0;
+    std::size_t batch = 1;
+    clock_t::duration elapsed = clock_t::duration::zero();
+    const std::size_t allocCountBefore = allocCount;
+    const std::size_t allocBytesBefore = allocBytes;
+    const clock_t::duration limit = boost::chrono::milliseconds( minTime );
+    while ( (elapsed < limit) || (iterations < minIterations) ) {
+        const clock_t::time_point start = clock_t::now();
+        for (std::size_t i = 0; i < batch; ++i) {
+            fn();
+        }
+        elapsed += clock_t::now() - start;
+        iterations += batch;
+        //  ,     clock_t::now()
+        if (batch < 1024) {
+            batch *= 2;
+        }
+    }
+
+    const double n = static_cast< double >( iterations );
+    Result r;
+    r.name = name;
+    r.iterations = iterations;
+    r.nsPerOp = static_cast< double >(
+        boost::chrono::duration_cast< boost::chrono::nanoseconds >( elapsed ).count()
+    ) / n;
+    r.allocsPerOp = static_cast< double >( allocCount - allocCountBefore ) / n;
+    r.bytesPerOp  = static_cast< double >( allocBytes - allocBytesBefore ) / n;
+    return r;
+}
+
+
+
+
+inline void printHeader( std::ostream& out ) {
+    out << std::left  << std::setw( 40 ) << "case"
+        << std::right << std::setw( 12 ) << "iterations"
+        << std::setw( 16 ) << "ns/op"
+        << std::setw( 14 ) << "allocs/op"
+        << std::setw( 14 ) << "bytes/op"
+        << std::endl;
+}
+
+
+
+
+inline std::ostream& operator<<( std::ostream& out, const Result& r ) {
+    out << std::left  << std::setw( 40 ) << r.name
+        << std::right << std::setw( 12 ) << r.iterations
+        << std::fixed << std::setprecision( 1 )
+        << std::setw( 16 ) << r.nsPerOp
+        << std::setw( 14 ) << r.allocsPerOp
+        << std::setw( 14 ) << r.bytesPerOp
+        << std::endl;
+    return out;
+}
+
+
+} // bench
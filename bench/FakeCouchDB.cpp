@@ -0,0 +1,1686 @@
+#include "FakeCouchDB.h"
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/regex.hpp>
+#include <zlib.h>
+
+
+using namespace bench;
+using boost::asio::ip::tcp;
+
+
+
+
+FakeCouchDB::FakeCouchDB( const Settings& settings, unsigned short port ) :
+    settings( settings ),
+    acceptor( service, tcp::endpoint( boost::asio::ip::address_v4::loopback(), port ) ),
+    stopped( false ),
+    uidCounter( 0 ),
+    seqCounter( 0 ),
+    requestCounter( 0 ),
+    bytesCounter( 0 ),
+    random( settings.seed )
+{
+    acceptThread = boost::thread( boost::bind( &FakeCouchDB::accept, this ) );
+}
+
+
+
+
+FakeCouchDB::~FakeCouchDB() {
+    {
+        boost::mutex::scoped_lock lock( mutex );
+        stopped = true;
+        for (auto itr = sockets.begin(); itr != sockets.end(); ++itr) {
+            boost::system::error_code ec;
+            (*itr)->shutdown( tcp::socket::shutdown_both, ec );
+        }
+    }
+
+    //  accept():      
+    try {
+        tcp::socket wakeup( service );
+        wakeup.connect( acceptor.local_endpoint() );
+    } catch ( ... ) {
+    }
+    acceptThread.join();
+
+    boost::system::error_code ec;
+    acceptor.close( ec );
+    connections.join_all();
+}
+
+
+
+
+std::string FakeCouchDB::url() const {
+    return "http://127.0.0.1:" +
+        boost::lexical_cast< std::string >( acceptor.local_endpoint().port() );
+}
+
+
+
+
+void FakeCouchDB::setView(
+    const std::string& db,
+    const std::string& design,
+    const std::string& view,
+    const CouchFine::Array& rows
+) {
+    CouchFine::Array sorted = rows;
+    std::stable_sort( sorted.begin(), sorted.end(),
+        [] ( const CouchFine::Variant& a, const CouchFine::Variant& b ) -> bool {
+            const CouchFine::Object& oa = boost::any_cast< const CouchFine::Object& >( *a );
+            const CouchFine::Object& ob = boost::any_cast< const CouchFine::Object& >( *b );
+            const int c = collate( oa.at( "key" ), ob.at( "key" ) );
+            return (c != 0) ? (c < 0) : (CouchFine::uid( oa ) < CouchFine::uid( ob ));
+        }
+    );
+
+    boost::mutex::scoped_lock lock( mutex );
+    views[ db ][ design + "/" + view ] = sorted;
+    indexes[ db ][ design ] = Index();
+}
+
+
+
+
+void FakeCouchDB::setSettings( const Settings& s ) {
+    boost::mutex::scoped_lock lock( mutex );
+    settings = s;
+}
+
+
+
+
+std::size_t FakeCouchDB::requests() const {
+    boost::mutex::scoped_lock lock( mutex );
+    return requestCounter;
+}
+
+
+
+
+std::size_t FakeCouchDB::bytesReceived() const {
+    boost::mutex::scoped_lock lock( mutex );
+    return bytesCounter;
+}
+
+
+
+
+void FakeCouchDB::accept() {
+    for ( ;; ) {
+        socket_ptr socket( new tcp::socket( service ) );
+        boost::system::error_code ec;
+        acceptor.accept( *socket, ec );
+
+        boost::mutex::scoped_lock lock( mutex );
+        if ( stopped ) {
+            return;
+        }
+        if ( ec ) {
+            continue;
+        }
+        sockets.insert( socket );
+        connections.create_thread( boost::bind( &FakeCouchDB::serve, this, socket ) );
+    }
+}
+
+
+
+
+void FakeCouchDB::serve( socket_ptr socket ) {
+    boost::asio::streambuf in;
+    Request request;
+    try {
+        while ( readRequest( *socket, in, request ) ) {
+            const Response response = handle( request );
+            writeResponse( *socket, response );
+            const auto ftr = request.headers.find( "connection" );
+            if ( (ftr != request.headers.cend()) && boost::iequals( ftr->second, "close" ) ) {
+                break;
+            }
+        }
+    } catch ( const std::exception& ex ) {
+        std::cerr << "FakeCouchDB: " << ex.what() << std::endl;
+    }
+
+    boost::mutex::scoped_lock lock( mutex );
+    boost::system::error_code ec;
+    socket->close( ec );
+    sockets.erase( socket );
+}
+
+
+
+
+bool FakeCouchDB::readRequest(
+    tcp::socket& socket,
+    boost::asio::streambuf& in,
+    Request& request
+) {
+    boost::system::error_code ec;
+    boost::asio::read_until( socket, in, "\r\n\r\n", ec );
+    if ( ec ) {
+        return false;
+    }
+
+    request = Request();
+    std::istream is( &in );
+    std::string line;
+    std::getline( is, line );
+    boost::trim_right( line );
+    std::istringstream ls( line );
+    std::string target;
+    ls >> request.method >> target;
+
+    while ( std::getline( is, line ) ) {
+        boost::trim_right( line );
+        if ( line.empty() ) {
+            break;
+        }
+        const std::size_t colon = line.find( ':' );
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr( 0, colon );
+        boost::to_lower( name );
+        request.headers[ name ] = boost::trim_copy( line.substr( colon + 1 ) );
+    }
+
+    const std::size_t question = target.find( '?' );
+    request.path = decode( target.substr( 0, question ) );
+    if (question != std::string::npos) {
+        request.query = parseQuery( target.substr( question + 1 ) );
+    }
+
+    // curl      
+    const auto expect = request.headers.find( "expect" );
+    if ( (expect != request.headers.cend()) && boost::iequals( expect->second, "100-continue" ) ) {
+        boost::asio::write( socket, boost::asio::buffer( std::string( "HTTP/1.1 100 Continue\r\n\r\n" ) ) );
+    }
+
+    const auto length = request.headers.find( "content-length" );
+    const auto encoding = request.headers.find( "transfer-encoding" );
+    if (length != request.headers.cend()) {
+        const std::size_t n = boost::lexical_cast< std::size_t >( length->second );
+        if (in.size() < n) {
+            boost::asio::read( socket, in, boost::asio::transfer_exactly( n - in.size() ) );
+        }
+        request.body.resize( n );
+        if (n > 0) {
+            is.read( &request.body[ 0 ], n );
+        }
+
+    } else if ( (encoding != request.headers.cend()) && boost::iequals( encoding->second, "chunked" ) ) {
+        for ( ;; ) {
+            boost::asio::read_until( socket, in, "\r\n" );
+            std::getline( is, line );
+            const std::size_t n = std::strtoul( line.c_str(), nullptr, 16 );
+            //      "\r\n"
+            if (in.size() < n + 2) {
+                boost::asio::read( socket, in, boost::asio::transfer_exactly( n + 2 - in.size() ) );
+            }
+            std::string chunk( n + 2, '\0' );
+            is.read( &chunk[ 0 ], n + 2 );
+            if (n == 0) {
+                break;
+            }
+            request.body.append( chunk, 0, n );
+        }
+    }
+
+    request.received = request.body.size();
+    const auto contentEncoding = request.headers.find( "content-encoding" );
+    if ( (contentEncoding != request.headers.cend()) && boost::iequals( contentEncoding->second, "gzip" ) ) {
+        request.body = gunzip( request.body );
+    }
+
+    return true;
+}
+
+
+
+
+void FakeCouchDB::writeResponse( tcp::socket& socket, const Response& response ) {
+    std::string reason = "OK";
+    switch (response.status) {
+        case 201 : reason = "Created"; break;
+        case 202 : reason = "Accepted"; break;
+        case 304 : reason = "Not Modified"; break;
+        case 400 : reason = "Bad Request"; break;
+        case 404 : reason = "Object Not Found"; break;
+        case 405 : reason = "Method Not Allowed"; break;
+        case 409 : reason = "Conflict"; break;
+        case 412 : reason = "Precondition Failed"; break;
+        case 500 : reason = "Internal Server Error"; break;
+    }
+
+    std::ostringstream os;
+    os << "HTTP/1.1 " << response.status << " " << reason << "\r\n"
+       << "Server: FakeCouchDB\r\n"
+       << "Content-Type: " << response.contentType << "\r\n"
+       << "Content-Length: " << response.body.size() << "\r\n";
+    for (auto itr = response.headers.cbegin(); itr != response.headers.cend(); ++itr) {
+        os << itr->first << ": " << itr->second << "\r\n";
+    }
+    os << "\r\n" << response.body;
+    const std::string data = os.str();
+
+    std::size_t bandwidth = 0;
+    {
+        boost::mutex::scoped_lock lock( mutex );
+        bandwidth = settings.bandwidth;
+    }
+    if (bandwidth == 0) {
+        boost::asio::write( socket, boost::asio::buffer( data ) );
+        return;
+    }
+
+    //    10 
+    const std::size_t slice = std::max< std::size_t >( bandwidth / 100, 1 );
+    for (std::size_t offset = 0; offset < data.size(); offset += slice) {
+        const std::size_t n = std::min( slice, data.size() - offset );
+        boost::asio::write( socket, boost::asio::buffer( data.data() + offset, n ) );
+        boost::this_thread::sleep( boost::posix_time::milliseconds( 10 ) );
+    }
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handle( const Request& request ) {
+    std::vector< std::string >  segments;
+    boost::split( segments, request.path, boost::is_any_of( "/" ) );
+    segments.erase(
+        std::remove( segments.begin(), segments.end(), std::string() ),
+        segments.end()
+    );
+
+    std::size_t pause = 0;
+    bool fail = false;
+    {
+        boost::mutex::scoped_lock lock( mutex );
+        ++requestCounter;
+        bytesCounter += request.received;
+        pause = settings.latency;
+        if (settings.jitter > 0) {
+            pause += random() % (settings.jitter + 1);
+        }
+        //    :     Connection
+        fail = !segments.empty() && chance( settings.errorRate );
+    }
+    if (pause > 0) {
+        boost::this_thread::sleep( boost::posix_time::milliseconds( pause ) );
+    }
+    if ( fail ) {
+        return error( 500, "internal_server_error", "Injected by FakeCouchDB." );
+    }
+
+    if ( segments.empty() ) {
+        CouchFine::Object o;
+        o[ "couchdb" ] = typelib::json::cjv( std::string( "Welcome" ) );
+        o[ "version" ] = typelib::json::cjv( std::string( "1.2.0" ) );
+        return json( 200, typelib::json::cjv( o ) );
+    }
+
+    if (segments[ 0 ] == "_all_dbs") {
+        boost::mutex::scoped_lock lock( mutex );
+        CouchFine::Array a;
+        for (auto itr = dbs.cbegin(); itr != dbs.cend(); ++itr) {
+            a.push_back( typelib::json::cjv( itr->first ) );
+        }
+        return json( 200, typelib::json::cjv( a ) );
+    }
+
+    if (segments[ 0 ] == "_active_tasks") {
+        return handleActiveTasks();
+    }
+
+    if (segments[ 0 ] == "_uuids") {
+        const auto ftr = request.query.find( "count" );
+        const std::size_t count = (ftr == request.query.cend())
+            ? 1 : boost::lexical_cast< std::size_t >( ftr->second );
+        boost::mutex::scoped_lock lock( mutex );
+        CouchFine::Array a;
+        for (std::size_t i = 0; i < count; ++i) {
+            a.push_back( typelib::json::cjv( nextUID() ) );
+        }
+        CouchFine::Object o;
+        o[ "uuids" ] = typelib::json::cjv( a );
+        return json( 200, typelib::json::cjv( o ) );
+    }
+
+    const std::string& db = segments[ 0 ];
+    if (segments.size() == 1) {
+        return handleDatabase( request, db );
+    }
+
+    {
+        boost::mutex::scoped_lock lock( mutex );
+        if (dbs.find( db ) == dbs.cend()) {
+            return error( 404, "not_found", "no_db_file" );
+        }
+    }
+
+    const std::string& second = segments[ 1 ];
+    if (second == "_bulk_docs") {
+        return handleBulkDocs( request, db );
+    }
+    if (second == "_all_docs") {
+        return handleAllDocs( request, db );
+    }
+    if (second == "_bulk_get") {
+        bool bulkGet = true;
+        {
+            boost::mutex::scoped_lock lock( mutex );
+            bulkGet = settings.bulkGet;
+        }
+        if ( bulkGet ) {
+            return handleBulkGet( request, db );
+        }
+    }
+    if (second == "_find") {
+        return handleFind( request, db );
+    }
+    if (second == "_changes") {
+        return handleChanges( request, db );
+    }
+    if (second == "_index") {
+        return handleIndex( request, db );
+    }
+    if ( (second == "_design") && (segments.size() >= 3) ) {
+        const std::string id = "_design/" + segments[ 2 ];
+        if ( (segments.size() >= 5) && (segments[ 3 ] == "_view") ) {
+            return handleView( request, db, segments[ 2 ], segments[ 4 ] );
+        }
+        if ( (segments.size() >= 5) && (segments[ 3 ] == "_update") ) {
+            return handleUpdate( request, db, segments[ 2 ], segments[ 4 ], (segments.size() >= 6) ? segments[ 5 ] : "" );
+        }
+        return (segments.size() == 3)
+            ? handleDocument( request, db, id )
+            : handleAttachment( request, db, id, segments[ 3 ] );
+    }
+
+    return (segments.size() == 2)
+        ? handleDocument( request, db, second )
+        : handleAttachment( request, db, second, segments[ 2 ] );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleDatabase( const Request& request, const std::string& db ) {
+    boost::mutex::scoped_lock lock( mutex );
+    const auto ftr = dbs.find( db );
+
+    if (request.method == "PUT") {
+        if (ftr != dbs.cend()) {
+            return error( 412, "file_exists", "The database could not be created, the file already exists." );
+        }
+        dbs[ db ];
+        CouchFine::Object o;
+        o[ "ok" ] = typelib::json::cjv( true );
+        return json( 201, typelib::json::cjv( o ) );
+    }
+
+    if (ftr == dbs.cend()) {
+        return error( 404, "not_found", "no_db_file" );
+    }
+
+    if (request.method == "DELETE") {
+        dbs.erase( ftr );
+        views.erase( db );
+        CouchFine::Object o;
+        o[ "ok" ] = typelib::json::cjv( true );
+        return json( 200, typelib::json::cjv( o ) );
+    }
+
+    if (request.method == "POST") {
+        const CouchFine::Variant var = CouchFine::Communication::parseData( request.body );
+        const CouchFine::Object r = writeDoc(
+            ftr->second, boost::any_cast< CouchFine::Object >( *var ), true
+        );
+        return json( CouchFine::hasError( r ) ? 409 : 201, typelib::json::cjv( r ) );
+    }
+
+    int count = 0;
+    for (auto itr = ftr->second.cbegin(); itr != ftr->second.cend(); ++itr) {
+        count += itr->second.deleted ? 0 : 1;
+    }
+    CouchFine::Object o;
+    o[ "db_name" ] = typelib::json::cjv( db );
+    o[ "doc_count" ] = typelib::json::cjv( count );
+    o[ "update_seq" ] = typelib::json::cjv( static_cast< int >( seqCounter ) );
+    return json( 200, typelib::json::cjv( o ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleDocument(
+    const Request& request,
+    const std::string& db,
+    const std::string& id
+) {
+    boost::mutex::scoped_lock lock( mutex );
+    docs_t& docs = dbs[ db ];
+    const auto ftr = docs.find( id );
+    const bool exists = (ftr != docs.end()) && !ftr->second.deleted;
+    const auto rtr = request.query.find( "rev" );
+
+    if (request.method == "GET") {
+        if ( !exists ) {
+            return error( 404, "not_found", (ftr == docs.end()) ? "missing" : "deleted" );
+        }
+        //    
+        if ( (rtr != request.query.cend()) && (rtr->second != ftr->second.rev) ) {
+            return error( 404, "not_found", "missing" );
+        }
+        CouchFine::Object o = docObject( id, ftr->second );
+        const auto itr = request.query.find( "revs_info" );
+        if ( (itr != request.query.cend()) && (itr->second == "true") ) {
+            CouchFine::Object info;
+            info[ "rev" ] = typelib::json::cjv( ftr->second.rev );
+            info[ "status" ] = typelib::json::cjv( std::string( "available" ) );
+            CouchFine::Array a;
+            a.push_back( typelib::json::cjv( info ) );
+            o[ "_revs_info" ] = typelib::json::cjv( a );
+        }
+        return json( 200, typelib::json::cjv( o ) );
+    }
+
+    if (request.method == "PUT") {
+        const CouchFine::Variant var = CouchFine::Communication::parseData( request.body );
+        CouchFine::Object body = boost::any_cast< CouchFine::Object >( *var );
+        body[ "_id" ] = typelib::json::cjv( id );
+        if ( (rtr != request.query.cend()) && !CouchFine::hasRevision( body ) ) {
+            body[ "_rev" ] = typelib::json::cjv( rtr->second );
+        }
+        const CouchFine::Object r = writeDoc( docs, body, true );
+        return json( CouchFine::hasError( r ) ? 409 : 201, typelib::json::cjv( r ) );
+    }
+
+    if (request.method == "DELETE") {
+        if ( !exists ) {
+            return error( 404, "not_found", "missing" );
+        }
+        CouchFine::Object body;
+        body[ "_id" ] = typelib::json::cjv( id );
+        body[ "_rev" ] = typelib::json::cjv(
+            (rtr == request.query.cend()) ? std::string() : rtr->second
+        );
+        body[ "_deleted" ] = typelib::json::cjv( true );
+        const CouchFine::Object r = writeDoc( docs, body, false );
+        return json( CouchFine::hasError( r ) ? 409 : 200, typelib::json::cjv( r ) );
+    }
+
+    return error( 405, "method_not_allowed", "Only GET, PUT, DELETE allowed" );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleAttachment(
+    const Request& request,
+    const std::string& db,
+    const std::string& id,
+    const std::string& name
+) {
+    boost::mutex::scoped_lock lock( mutex );
+    docs_t& docs = dbs[ db ];
+    auto ftr = docs.find( id );
+    const bool exists = (ftr != docs.end()) && !ftr->second.deleted;
+
+    if (request.method == "GET") {
+        if ( !exists ) {
+            return error( 404, "not_found", "missing" );
+        }
+        const auto atr = ftr->second.attachments.find( name );
+        if (atr == ftr->second.attachments.cend()) {
+            return error( 404, "not_found", "Document is missing attachment" );
+        }
+        Response r;
+        r.contentType = atr->second.first;
+        r.body = atr->second.second;
+        return r;
+    }
+
+    const auto rtr = request.query.find( "rev" );
+    const std::string rev = (rtr == request.query.cend()) ? "" : rtr->second;
+    if ( exists && (rev != ftr->second.rev) ) {
+        return error( 409, "conflict", "Document update conflict." );
+    }
+
+    if (request.method == "PUT") {
+        if ( !exists ) {
+            //   
+            CouchFine::Object body;
+            body[ "_id" ] = typelib::json::cjv( id );
+            writeDoc( docs, body, false );
+            ftr = docs.find( id );
+        }
+        const auto ctr = request.headers.find( "content-type" );
+        ftr->second.attachments[ name ] = std::make_pair(
+            (ctr == request.headers.cend()) ? std::string( "application/octet-stream" ) : ctr->second,
+            request.body
+        );
+
+    } else if (request.method == "DELETE") {
+        if ( !exists || (ftr->second.attachments.erase( name ) == 0) ) {
+            return error( 404, "not_found", "Document is missing attachment" );
+        }
+
+    } else {
+        return error( 405, "method_not_allowed", "Only GET, PUT, DELETE allowed" );
+    }
+
+    //    
+    Doc& doc = ftr->second;
+    ++doc.generation;
+    doc.seq = ++seqCounter;
+    doc.rev = boost::lexical_cast< std::string >( doc.generation ) + "-" + nextUID();
+    CouchFine::Object o;
+    o[ "ok" ] = typelib::json::cjv( true );
+    o[ "id" ] = typelib::json::cjv( id );
+    o[ "rev" ] = typelib::json::cjv( doc.rev );
+    return json( 201, typelib::json::cjv( o ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleBulkDocs( const Request& request, const std::string& db ) {
+    if (request.method != "POST") {
+        return error( 405, "method_not_allowed", "Only POST allowed" );
+    }
+
+    const CouchFine::Variant var = CouchFine::Communication::parseData( request.body );
+    const CouchFine::Object o = boost::any_cast< CouchFine::Object >( *var );
+    const auto ftr = o.find( "docs" );
+    if (ftr == o.cend()) {
+        return error( 400, "bad_request", "Missing JSON list of 'docs'" );
+    }
+    const CouchFine::Array docs = boost::any_cast< CouchFine::Array >( *ftr->second );
+    const bool newEdits = CouchFine::v< bool >( o, "new_edits", true );
+
+    boost::mutex::scoped_lock lock( mutex );
+    docs_t& store = dbs[ db ];
+    CouchFine::Array result;
+    for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+        CouchFine::Object body = boost::any_cast< CouchFine::Object >( **itr );
+        if ( !newEdits ) {
+            // :    
+            const auto dtr = store.find( CouchFine::uid( body ) );
+            if (dtr != store.end()) {
+                body[ "_rev" ] = typelib::json::cjv( dtr->second.rev );
+            }
+        }
+        result.push_back( typelib::json::cjv( writeDoc( store, body, newEdits ) ) );
+    }
+
+    return json( 201, typelib::json::cjv( result ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleAllDocs( const Request& request, const std::string& db ) {
+    const auto param = [ &request ] ( const std::string& name ) -> std::string {
+        const auto ftr = request.query.find( name );
+        return (ftr == request.query.cend()) ? "" : ftr->second;
+    };
+    //    -  JSON
+    const auto key = [ &param ] ( const std::string& name ) -> std::string {
+        const std::string value = param( name );
+        if ( value.empty() ) {
+            return value;
+        }
+        const CouchFine::Variant var = CouchFine::Communication::parseData( value );
+        return boost::any_cast< std::string >( *var );
+    };
+
+    const bool includeDocs = (param( "include_docs" ) == "true");
+    const bool descending = (param( "descending" ) == "true");
+    const std::string limitParam = param( "limit" );
+    const std::size_t limit = limitParam.empty()
+        ? std::numeric_limits< std::size_t >::max()
+        : boost::lexical_cast< std::size_t >( limitParam );
+    const std::string skipParam = param( "skip" );
+    const std::size_t skip = skipParam.empty() ? 0 : boost::lexical_cast< std::size_t >( skipParam );
+
+    //      POST-    'keys'
+    CouchFine::Array keys;
+    bool byKeys = false;
+    if ( !request.body.empty() ) {
+        const CouchFine::Variant var = CouchFine::Communication::parseData( request.body );
+        const CouchFine::Object o = boost::any_cast< CouchFine::Object >( *var );
+        const auto ftr = o.find( "keys" );
+        if (ftr != o.cend()) {
+            keys = boost::any_cast< CouchFine::Array >( *ftr->second );
+            byKeys = true;
+        }
+    } else if ( !param( "keys" ).empty() ) {
+        const CouchFine::Variant var = CouchFine::Communication::parseData( param( "keys" ) );
+        keys = boost::any_cast< CouchFine::Array >( *var );
+        byKeys = true;
+    }
+
+    boost::mutex::scoped_lock lock( mutex );
+    const docs_t& docs = dbs[ db ];
+    int total = 0;
+    for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+        total += itr->second.deleted ? 0 : 1;
+    }
+
+    CouchFine::Array rows;
+    //    
+    std::size_t offset = 0;
+    if ( byKeys ) {
+        for (auto itr = keys.cbegin(); itr != keys.cend(); ++itr) {
+            const std::string id = boost::any_cast< std::string >( **itr );
+            const auto ftr = docs.find( id );
+            if (ftr == docs.cend()) {
+                CouchFine::Object row;
+                row[ "key" ] = typelib::json::cjv( id );
+                row[ "error" ] = typelib::json::cjv( std::string( "not_found" ) );
+                rows.push_back( typelib::json::cjv( row ) );
+            } else {
+                rows.push_back( typelib::json::cjv( docRow( id, ftr->second, includeDocs ) ) );
+            }
+        }
+
+    } else {
+        std::string startkey = key( "startkey" );
+        std::string endkey = key( "endkey" );
+        if ( descending ) {
+            std::swap( startkey, endkey );
+        }
+        const bool inclusiveEnd = (param( "inclusive_end" ) != "false");
+        std::vector< const docs_t::value_type* >  range;
+        for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+            if ( itr->second.deleted ) {
+                continue;
+            }
+            if ( !startkey.empty() && (itr->first < startkey) ) {
+                ++offset;
+                continue;
+            }
+            if ( !endkey.empty() && ((itr->first > endkey) || (!inclusiveEnd && (itr->first == endkey))) ) {
+                break;
+            }
+            range.push_back( &( *itr ) );
+        }
+        if ( descending ) {
+            offset = total - offset - range.size();
+            std::reverse( range.begin(), range.end() );
+        }
+        for (std::size_t i = skip; (i < range.size()) && (rows.size() < limit); ++i) {
+            rows.push_back( typelib::json::cjv( docRow( range[ i ]->first, range[ i ]->second, includeDocs ) ) );
+        }
+    }
+
+    CouchFine::Object o;
+    o[ "total_rows" ] = typelib::json::cjv( total );
+    o[ "offset" ] = typelib::json::cjv( static_cast< int >( offset + skip ) );
+    o[ "rows" ] = typelib::json::cjv( rows );
+    return json( 200, typelib::json::cjv( o ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleView(
+    const Request& request,
+    const std::string& db,
+    const std::string& design,
+    const std::string& view
+) {
+    const auto param = [ &request ] ( const std::string& name ) -> std::string {
+        const auto ftr = request.query.find( name );
+        return (ftr == request.query.cend()) ? "" : ftr->second;
+    };
+    const bool includeDocs = (param( "include_docs" ) == "true");
+    const std::size_t limit = param( "limit" ).empty()
+        ? std::numeric_limits< std::size_t >::max()
+        : boost::lexical_cast< std::size_t >( param( "limit" ) );
+    const std::size_t skip = param( "skip" ).empty()
+        ? 0 : boost::lexical_cast< std::size_t >( param( "skip" ) );
+    const std::string stale = param( "stale" );
+    const bool inclusiveEnd = (param( "inclusive_end" ) != "false");
+    const std::string startkeyDocID = param( "startkey_docid" );
+    CouchFine::Variant startkey = param( "startkey" ).empty()
+        ? CouchFine::Variant() : CouchFine::Communication::parseData( param( "startkey" ) );
+    CouchFine::Variant endkey = param( "endkey" ).empty()
+        ? CouchFine::Variant() : CouchFine::Communication::parseData( param( "endkey" ) );
+    //    'startkey' -   (startkey_docid
+    //  inclusive_end    )
+    const bool descending = (param( "descending" ) == "true");
+    if ( descending ) {
+        std::swap( startkey, endkey );
+    }
+
+    boost::mutex::scoped_lock lock( mutex );
+    const auto vtr = views[ db ].find( design + "/" + view );
+    if (vtr == views[ db ].cend()) {
+        return error( 404, "not_found", "missing_named_view" );
+    }
+
+    //     ,    
+    Index& index = indexes[ db ][ design ];
+    if ( !index.started && (stale != "ok") ) {
+        index.started = true;
+        index.start = boost::posix_time::microsec_clock::universal_time();
+        index.ready = index.start + boost::posix_time::milliseconds( settings.indexTime );
+    }
+    if ( index.started && stale.empty() ) {
+        const boost::posix_time::ptime ready = index.ready;
+        lock.unlock();
+        boost::this_thread::sleep( ready );
+        lock.lock();
+    }
+
+    const CouchFine::Array& all = vtr->second;
+    const docs_t& docs = dbs[ db ];
+
+    //  , . setView()
+    std::size_t first = 0;
+    if ( startkey ) {
+        while (first < all.size()) {
+            const CouchFine::Object& row = boost::any_cast< const CouchFine::Object& >( *all[ first ] );
+            const int c = collate( row.at( "key" ), startkey );
+            if ( (c > 0) || ((c == 0) && (CouchFine::uid( row ) >= startkeyDocID)) ) {
+                break;
+            }
+            ++first;
+        }
+    }
+    std::size_t last = all.size();
+    if ( endkey ) {
+        last = first;
+        while (last < all.size()) {
+            const CouchFine::Object& row = boost::any_cast< const CouchFine::Object& >( *all[ last ] );
+            const int c = collate( row.at( "key" ), endkey );
+            if ( (c > 0) || ((c == 0) && !inclusiveEnd) ) {
+                break;
+            }
+            ++last;
+        }
+    }
+
+    CouchFine::Array rows;
+    for (std::size_t k = skip; (k < last - first) && (rows.size() < limit); ++k) {
+        const std::size_t i = descending ? (last - 1 - k) : (first + k);
+        CouchFine::Object row = boost::any_cast< CouchFine::Object >( *all[ i ] );
+        if ( includeDocs ) {
+            //     'doc' 
+            const auto ftr = docs.find( CouchFine::uid( row ) );
+            if ( (ftr != docs.cend()) && !ftr->second.deleted ) {
+                row[ "doc" ] = typelib::json::cjv( docObject( ftr->first, ftr->second ) );
+            }
+        }
+        rows.push_back( typelib::json::cjv( row ) );
+    }
+
+    CouchFine::Object o;
+    o[ "total_rows" ] = typelib::json::cjv( static_cast< int >( all.size() ) );
+    o[ "offset" ] = typelib::json::cjv( static_cast< int >( (descending ? (all.size() - last) : first) + skip ) );
+    o[ "rows" ] = typelib::json::cjv( rows );
+    Response r = json( 200, typelib::json::cjv( o ) );
+
+    // ETag -   :  - 304  
+    boost::uint64_t h = 14695981039346656037ULL;
+    for (auto itr = r.body.cbegin(); itr != r.body.cend(); ++itr) {
+        h = (h ^ static_cast< unsigned char >( *itr )) * 1099511628211ULL;
+    }
+    std::ostringstream etag;
+    etag << '"' << std::hex << h << '"';
+    r.headers[ "ETag" ] = etag.str();
+    const auto ftr = request.headers.find( "if-none-match" );
+    if ( (ftr != request.headers.cend()) && (ftr->second == etag.str()) ) {
+        r.status = 304;
+        r.body.clear();
+    }
+    return r;
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleActiveTasks() {
+    const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+    boost::mutex::scoped_lock lock( mutex );
+    CouchFine::Array tasks;
+    for (auto dtr = indexes.cbegin(); dtr != indexes.cend(); ++dtr) {
+        for (auto itr = dtr->second.cbegin(); itr != dtr->second.cend(); ++itr) {
+            const Index& index = itr->second;
+            if ( !index.started || (now >= index.ready) ) {
+                continue;
+            }
+            const double total = static_cast< double >( (index.ready - index.start).total_milliseconds() );
+            const double done = static_cast< double >( (now - index.start).total_milliseconds() );
+            CouchFine::Object task;
+            task[ "type" ] = typelib::json::cjv( std::string( "indexer" ) );
+            task[ "database" ] = typelib::json::cjv( dtr->first );
+            task[ "design_document" ] = typelib::json::cjv( "_design/" + itr->first );
+            task[ "progress" ] = typelib::json::cjv( static_cast< int >( 100.0 * done / total ) );
+            tasks.push_back( typelib::json::cjv( task ) );
+        }
+    }
+    return json( 200, typelib::json::cjv( tasks ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleUpdate(
+    const Request& request,
+    const std::string& db,
+    const std::string& design,
+    const std::string& handler,
+    const std::string& id
+) {
+    if ( (request.method != "POST") && !((request.method == "PUT") && !id.empty()) ) {
+        return error( 405, "method_not_allowed", "Only POST, PUT allowed" );
+    }
+    CouchFine::Object data;
+    if ( !request.body.empty() ) {
+        try {
+            data = boost::any_cast< CouchFine::Object >( *CouchFine::Communication::parseData( request.body ) );
+        } catch ( ... ) {
+            return error( 500, "render_error", "JSON.parse failed" );
+        }
+    }
+    const auto mtr = request.query.find( "mode" );
+    const bool update = (mtr != request.query.cend()) && (mtr->second == "update");
+
+    boost::mutex::scoped_lock lock( mutex );
+    docs_t& docs = dbs[ db ];
+    const auto dtr = docs.find( "_design/" + design );
+    bool found = (dtr != docs.cend()) && !dtr->second.deleted;
+    if ( found ) {
+        const auto utr = dtr->second.body.find( "updates" );
+        found = (utr != dtr->second.body.cend())
+            && (boost::any_cast< CouchFine::Object >( *utr->second ).count( handler ) > 0);
+    }
+    if ( !found ) {
+        return error( 404, "not_found", "missing function " + handler + " on design doc _design/" + design );
+    }
+
+    const std::string docId = !id.empty() ? id
+        : (CouchFine::hasUID( data ) ? CouchFine::uid( data ) : nextUID());
+    const auto ftr = docs.find( docId );
+    CouchFine::Object doc;
+    bool changed = false;
+    if ( (ftr != docs.cend()) && !ftr->second.deleted ) {
+        doc = docObject( docId, ftr->second );
+    } else {
+        doc[ "_id" ] = typelib::json::cjv( docId );
+        changed = true;
+    }
+    changed = merge( doc, data, update ) || changed;
+
+    if ( changed ) {
+        const CouchFine::Object r = writeDoc( docs, doc, true );
+        if ( CouchFine::hasError( r ) ) {
+            return json( 409, typelib::json::cjv( r ) );
+        }
+    }
+    CouchFine::Object o;
+    o[ "ok" ] = typelib::json::cjv( true );
+    o[ "id" ] = typelib::json::cjv( docId );
+    o[ "changed" ] = typelib::json::cjv( changed );
+    return json( changed ? 201 : 200, typelib::json::cjv( o ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleBulkGet( const Request& request, const std::string& db ) {
+    if (request.method != "POST") {
+        return error( 405, "method_not_allowed", "Only POST allowed" );
+    }
+    CouchFine::Object query;
+    try {
+        query = boost::any_cast< CouchFine::Object >( *CouchFine::Communication::parseData( request.body ) );
+    } catch ( ... ) {
+        return error( 400, "bad_request", "invalid_json" );
+    }
+    const auto ftr = query.find( "docs" );
+    if (ftr == query.cend()) {
+        return error( 400, "bad_request", "Missing JSON list of 'docs'." );
+    }
+    const CouchFine::Array wanted = boost::any_cast< CouchFine::Array >( *ftr->second );
+
+    boost::mutex::scoped_lock lock( mutex );
+    const docs_t& docs = dbs[ db ];
+    CouchFine::Array results;
+    for (auto itr = wanted.cbegin(); itr != wanted.cend(); ++itr) {
+        const CouchFine::Object w = boost::any_cast< CouchFine::Object >( **itr );
+        const std::string id = boost::any_cast< std::string >( *w.at( "id" ) );
+        const auto rtr = w.find( "rev" );
+        const std::string rev = (rtr == w.cend()) ? "" : boost::any_cast< std::string >( *rtr->second );
+
+        const auto dtr = docs.find( id );
+        CouchFine::Object d;
+        if ( (dtr == docs.cend()) || dtr->second.deleted || (!rev.empty() && (rev != dtr->second.rev)) ) {
+            CouchFine::Object e;
+            e[ "id" ] = typelib::json::cjv( id );
+            e[ "rev" ] = typelib::json::cjv( rev.empty() ? std::string( "undefined" ) : rev );
+            e[ "error" ] = typelib::json::cjv( std::string( "not_found" ) );
+            e[ "reason" ] = typelib::json::cjv( std::string(
+                ( (dtr != docs.cend()) && dtr->second.deleted && rev.empty() ) ? "deleted" : "missing"
+            ) );
+            d[ "error" ] = typelib::json::cjv( e );
+        } else {
+            d[ "ok" ] = typelib::json::cjv( docObject( id, dtr->second ) );
+        }
+        CouchFine::Array a;
+        a.push_back( typelib::json::cjv( d ) );
+        CouchFine::Object r;
+        r[ "id" ] = typelib::json::cjv( id );
+        r[ "docs" ] = typelib::json::cjv( a );
+        results.push_back( typelib::json::cjv( r ) );
+    }
+
+    CouchFine::Object o;
+    o[ "results" ] = typelib::json::cjv( results );
+    return json( 200, typelib::json::cjv( o ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleFind( const Request& request, const std::string& db ) {
+    if (request.method != "POST") {
+        return error( 405, "method_not_allowed", "Only POST allowed" );
+    }
+    CouchFine::Object query;
+    try {
+        query = boost::any_cast< CouchFine::Object >( *CouchFine::Communication::parseData( request.body ) );
+    } catch ( ... ) {
+        return error( 400, "bad_request", "invalid_json" );
+    }
+    const auto get = [ &query ] ( const std::string& name ) -> CouchFine::Variant {
+        const auto ftr = query.find( name );
+        return (ftr == query.cend()) ? CouchFine::Variant() : ftr->second;
+    };
+
+    const CouchFine::Variant selectorVar = get( "selector" );
+    if ( !selectorVar || (selectorVar->type() != typeid( CouchFine::Object )) ) {
+        return error( 400, "missing_required_key", "Missing required key: selector" );
+    }
+    const CouchFine::Object selector = boost::any_cast< CouchFine::Object >( *selectorVar );
+    const std::size_t limit = get( "limit" ) ? static_cast< std::size_t >( static_cast< int >( get( "limit" ) ) ) : 25;
+    const std::size_t skip = get( "skip" ) ? static_cast< std::size_t >( static_cast< int >( get( "skip" ) ) ) : 0;
+    //  -  ,    
+    const std::size_t start = get( "bookmark" )
+        ? boost::lexical_cast< std::size_t >( boost::any_cast< std::string >( *get( "bookmark" ) ) ) : 0;
+
+    // (,  )
+    std::vector< std::pair< std::string, bool > >  sort;
+    if ( get( "sort" ) ) {
+        const CouchFine::Array a = boost::any_cast< CouchFine::Array >( *get( "sort" ) );
+        for (auto itr = a.cbegin(); itr != a.cend(); ++itr) {
+            if ((*itr)->type() == typeid( std::string )) {
+                sort.push_back( std::make_pair( boost::any_cast< std::string >( **itr ), false ) );
+                continue;
+            }
+            const CouchFine::Object o = boost::any_cast< CouchFine::Object >( **itr );
+            sort.push_back( std::make_pair(
+                o.begin()->first,
+                boost::any_cast< std::string >( *o.begin()->second ) == "desc"
+            ) );
+        }
+    }
+
+    std::vector< CouchFine::Object >  found;
+    {
+        boost::mutex::scoped_lock lock( mutex );
+        const docs_t& docs = dbs[ db ];
+        for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+            if ( itr->second.deleted || (itr->first.compare( 0, 8, "_design/" ) == 0) ) {
+                continue;
+            }
+            const CouchFine::Object doc = docObject( itr->first, itr->second );
+            if ( matches( doc, selector ) ) {
+                found.push_back( doc );
+            }
+        }
+    }
+    std::stable_sort( found.begin(), found.end(),
+        [ &sort ] ( const CouchFine::Object& a, const CouchFine::Object& b ) -> bool {
+            for (auto itr = sort.cbegin(); itr != sort.cend(); ++itr) {
+                const int c = collate( field( a, itr->first ), field( b, itr->first ) );
+                if (c != 0) {
+                    return itr->second ? (c > 0) : (c < 0);
+                }
+            }
+            return false;
+        }
+    );
+
+    CouchFine::Array fields;
+    if ( get( "fields" ) ) {
+        fields = boost::any_cast< CouchFine::Array >( *get( "fields" ) );
+    }
+    CouchFine::Array result;
+    std::size_t i = start + skip;
+    for ( ; (i < found.size()) && (result.size() < limit); ++i) {
+        if ( fields.empty() ) {
+            result.push_back( typelib::json::cjv( found[ i ] ) );
+            continue;
+        }
+        //    :     
+        CouchFine::Object projected;
+        for (auto ftr = fields.cbegin(); ftr != fields.cend(); ++ftr) {
+            const std::string name = boost::any_cast< std::string >( **ftr );
+            const auto vtr = found[ i ].find( name );
+            if (vtr != found[ i ].cend()) {
+                projected[ name ] = vtr->second;
+            }
+        }
+        result.push_back( typelib::json::cjv( projected ) );
+    }
+
+    CouchFine::Object o;
+    o[ "docs" ] = typelib::json::cjv( result );
+    o[ "bookmark" ] = typelib::json::cjv( boost::lexical_cast< std::string >( i ) );
+    return json( 200, typelib::json::cjv( o ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleChanges( const Request& request, const std::string& db ) {
+    if (request.method != "GET") {
+        return error( 405, "method_not_allowed", "Only GET allowed" );
+    }
+    const auto param = [ &request ] ( const std::string& name ) -> std::string {
+        const auto ftr = request.query.find( name );
+        return (ftr == request.query.cend()) ? "" : ftr->second;
+    };
+
+    const bool includeDocs = (param( "include_docs" ) == "true");
+    const bool longpoll = (param( "feed" ) == "longpoll");
+    const std::string limitParam = param( "limit" );
+    const std::size_t limit = limitParam.empty()
+        ? std::numeric_limits< std::size_t >::max()
+        : boost::lexical_cast< std::size_t >( limitParam );
+    const std::string timeoutParam = param( "timeout" );
+    const std::size_t timeout = timeoutParam.empty()
+        ? 60000 : boost::lexical_cast< std::size_t >( timeoutParam );
+    const boost::posix_time::ptime until =
+        boost::posix_time::microsec_clock::universal_time()
+      + boost::posix_time::milliseconds( timeout );
+
+    boost::mutex::scoped_lock lock( mutex );
+    const std::string sinceParam = param( "since" );
+    const std::size_t since =
+        (sinceParam == "now") ? seqCounter
+      : (sinceParam.empty() ? 0 : boost::lexical_cast< std::size_t >( sinceParam ));
+
+    // (seq, id)   'since' ; longpoll 
+    //  ,  'mutex'
+    std::vector< std::pair< std::size_t, std::string > >  changed;
+    for ( ; ; ) {
+        const auto ftr = dbs.find( db );
+        if (ftr == dbs.end()) {
+            return error( 404, "not_found", "Database does not exist." );
+        }
+        for (auto itr = ftr->second.cbegin(); itr != ftr->second.cend(); ++itr) {
+            if (itr->second.seq > since) {
+                changed.push_back( std::make_pair( itr->second.seq, itr->first ) );
+            }
+        }
+        if ( !changed.empty() || !longpoll || stopped
+          || (boost::posix_time::microsec_clock::universal_time() >= until)
+        ) {
+            break;
+        }
+        lock.unlock();
+        boost::this_thread::sleep( boost::posix_time::milliseconds( 10 ) );
+        lock.lock();
+    }
+    std::sort( changed.begin(), changed.end() );
+    if (changed.size() > limit) {
+        changed.resize( limit );
+    }
+
+    const docs_t& docs = dbs[ db ];
+    CouchFine::Array results;
+    for (auto itr = changed.cbegin(); itr != changed.cend(); ++itr) {
+        const Doc& doc = docs.find( itr->second )->second;
+        CouchFine::Object change;
+        change[ "seq" ] = typelib::json::cjv( static_cast< int >( itr->first ) );
+        change[ "id" ] = typelib::json::cjv( itr->second );
+        CouchFine::Object rev;
+        rev[ "rev" ] = typelib::json::cjv( doc.rev );
+        CouchFine::Array revs;
+        revs.push_back( typelib::json::cjv( rev ) );
+        change[ "changes" ] = typelib::json::cjv( revs );
+        if ( doc.deleted ) {
+            change[ "deleted" ] = typelib::json::cjv( true );
+        }
+        if ( includeDocs ) {
+            CouchFine::Object o;
+            if ( doc.deleted ) {
+                o[ "_id" ] = typelib::json::cjv( itr->second );
+                o[ "_rev" ] = typelib::json::cjv( doc.rev );
+                o[ "_deleted" ] = typelib::json::cjv( true );
+            } else {
+                o = docObject( itr->second, doc );
+            }
+            change[ "doc" ] = typelib::json::cjv( o );
+        }
+        results.push_back( typelib::json::cjv( change ) );
+    }
+
+    CouchFine::Object o;
+    o[ "results" ] = typelib::json::cjv( results );
+    o[ "last_seq" ] = typelib::json::cjv( static_cast< int >(
+        changed.empty() ? since : changed.back().first
+    ) );
+    return json( 200, typelib::json::cjv( o ) );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::handleIndex( const Request& request, const std::string& db ) {
+    boost::mutex::scoped_lock lock( mutex );
+    docs_t& docs = dbs[ db ];
+
+    if (request.method == "POST") {
+        CouchFine::Object query;
+        try {
+            query = boost::any_cast< CouchFine::Object >( *CouchFine::Communication::parseData( request.body ) );
+        } catch ( ... ) {
+            return error( 400, "bad_request", "invalid_json" );
+        }
+        const auto itr = query.find( "index" );
+        if (itr == query.cend()) {
+            return error( 400, "missing_required_key", "Missing required key: index" );
+        }
+        const std::string def = toJSON( itr->second );
+        const std::string hash = boost::lexical_cast< std::string >( boost::hash< std::string >()( def ) );
+        const auto ntr = query.find( "name" );
+        const auto dtr = query.find( "ddoc" );
+        const std::string name = (ntr == query.cend()) ? hash : boost::any_cast< std::string >( *ntr->second );
+        const std::string id = "_design/" + ( (dtr == query.cend()) ? hash : boost::any_cast< std::string >( *dtr->second ) );
+
+        CouchFine::Object r;
+        r[ "id" ] = typelib::json::cjv( id );
+        r[ "name" ] = typelib::json::cjv( name );
+        const auto ftr = docs.find( id );
+        CouchFine::Object design;
+        if ( (ftr != docs.cend()) && !ftr->second.deleted ) {
+            design = docObject( id, ftr->second );
+            const auto vtr = design.find( "views" );
+            if ( (vtr != design.cend()) && (boost::any_cast< CouchFine::Object >( *vtr->second ).count( name ) > 0) ) {
+                r[ "result" ] = typelib::json::cjv( std::string( "exists" ) );
+                return json( 200, typelib::json::cjv( r ) );
+            }
+        } else {
+            design[ "_id" ] = typelib::json::cjv( id );
+            design[ "language" ] = typelib::json::cjv( std::string( "query" ) );
+        }
+
+        CouchFine::Object views;
+        const auto vtr = design.find( "views" );
+        if (vtr != design.cend()) {
+            views = boost::any_cast< CouchFine::Object >( *vtr->second );
+        }
+        CouchFine::Object options;
+        options[ "def" ] = itr->second;
+        CouchFine::Object view;
+        view[ "options" ] = typelib::json::cjv( options );
+        views[ name ] = typelib::json::cjv( view );
+        design[ "views" ] = typelib::json::cjv( views );
+        writeDoc( docs, design, false );
+        r[ "result" ] = typelib::json::cjv( std::string( "created" ) );
+        return json( 200, typelib::json::cjv( r ) );
+    }
+
+    CouchFine::Array indexes;
+    {
+        CouchFine::Object fields;
+        fields[ "_id" ] = typelib::json::cjv( std::string( "asc" ) );
+        CouchFine::Array a;
+        a.push_back( typelib::json::cjv( fields ) );
+        CouchFine::Object def;
+        def[ "fields" ] = typelib::json::cjv( a );
+        CouchFine::Object index;
+        index[ "ddoc" ] = typelib::json::cjv( boost::any() );
+        index[ "name" ] = typelib::json::cjv( std::string( "_all_docs" ) );
+        index[ "type" ] = typelib::json::cjv( std::string( "special" ) );
+        index[ "def" ] = typelib::json::cjv( def );
+        indexes.push_back( typelib::json::cjv( index ) );
+    }
+    for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+        const CouchFine::Object& body = itr->second.body;
+        const auto ltr = body.find( "language" );
+        if ( itr->second.deleted || (ltr == body.cend())
+          || (boost::any_cast< std::string >( *ltr->second ) != "query")
+        ) {
+            continue;
+        }
+        const CouchFine::Object views = boost::any_cast< CouchFine::Object >( *body.at( "views" ) );
+        for (auto vtr = views.cbegin(); vtr != views.cend(); ++vtr) {
+            const CouchFine::Object view = boost::any_cast< CouchFine::Object >( *vtr->second );
+            const CouchFine::Object options = boost::any_cast< CouchFine::Object >( *view.at( "options" ) );
+            CouchFine::Object index;
+            index[ "ddoc" ] = typelib::json::cjv( itr->first );
+            index[ "name" ] = typelib::json::cjv( vtr->first );
+            index[ "type" ] = typelib::json::cjv( std::string( "json" ) );
+            index[ "def" ] = options.at( "def" );
+            indexes.push_back( typelib::json::cjv( index ) );
+        }
+    }
+
+    CouchFine::Object o;
+    o[ "total_rows" ] = typelib::json::cjv( static_cast< int >( indexes.size() ) );
+    o[ "indexes" ] = typelib::json::cjv( indexes );
+    return json( 200, typelib::json::cjv( o ) );
+}
+
+
+
+
+CouchFine::Object FakeCouchDB::writeDoc( docs_t& docs, CouchFine::Object body, bool allowConflict ) {
+    std::string id = CouchFine::uid( body );
+    if ( id.empty() ) {
+        id = nextUID();
+    }
+    const std::string rev = CouchFine::revision( body );
+
+    const auto ftr = docs.find( id );
+    const bool exists = (ftr != docs.end()) && !ftr->second.deleted;
+    const bool conflict =
+        ( exists && (rev != ftr->second.rev) )
+     || ( allowConflict && chance( settings.conflictRate ) );
+
+    CouchFine::Object r;
+    r[ "id" ] = typelib::json::cjv( id );
+    if ( conflict ) {
+        r[ "error" ] = typelib::json::cjv( std::string( "conflict" ) );
+        r[ "reason" ] = typelib::json::cjv( std::string( "Document update conflict." ) );
+        return r;
+    }
+
+    Doc& doc = docs[ id ];
+    doc.deleted = CouchFine::v< bool >( body, "_deleted", false );
+
+    // ,    
+    const auto atr = body.find( "_attachments" );
+    if ( (atr != body.end()) && !doc.deleted ) {
+        const CouchFine::Object attachments = boost::any_cast< CouchFine::Object >( *atr->second );
+        for (auto itr = attachments.cbegin(); itr != attachments.cend(); ++itr) {
+            const CouchFine::Object a = boost::any_cast< CouchFine::Object >( *itr->second );
+            if (a.find( "data" ) != a.cend()) {
+                doc.attachments[ itr->first ] = std::make_pair(
+                    CouchFine::v< std::string >( a, "content_type", "application/octet-stream" ),
+                    CouchFine::v< std::string >( a, "data" )
+                );
+            }
+        }
+    }
+    if ( doc.deleted ) {
+        doc.attachments.clear();
+    }
+
+    body.erase( "_id" );
+    body.erase( "_rev" );
+    body.erase( "_deleted" );
+    body.erase( "_attachments" );
+    doc.body = body;
+    ++doc.generation;
+    doc.seq = ++seqCounter;
+    doc.rev = boost::lexical_cast< std::string >( doc.generation ) + "-" + nextUID();
+
+    r[ "ok" ] = typelib::json::cjv( true );
+    r[ "rev" ] = typelib::json::cjv( doc.rev );
+    return r;
+}
+
+
+
+
+std::string FakeCouchDB::nextUID() {
+    std::ostringstream os;
+    os << std::hex << std::setfill( '0' ) << std::setw( 16 ) << random()
+       << std::setw( 16 ) << ++uidCounter;
+    return os.str();
+}
+
+
+
+
+bool FakeCouchDB::chance( std::size_t perMille ) {
+    return (perMille > 0) && ( (random() % 1000) < perMille );
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::json( int status, const CouchFine::Variant& body ) {
+    Response r;
+    r.status = status;
+    r.body = toJSON( body );
+    return r;
+}
+
+
+
+
+FakeCouchDB::Response FakeCouchDB::error(
+    int status,
+    const std::string& error,
+    const std::string& reason
+) {
+    CouchFine::Object o;
+    o[ "error" ] = typelib::json::cjv( error );
+    o[ "reason" ] = typelib::json::cjv( reason );
+    return json( status, typelib::json::cjv( o ) );
+}
+
+
+
+
+std::string FakeCouchDB::toJSON( const CouchFine::Variant& var ) {
+    std::ostringstream os;
+    os << var;
+    return os.str();
+}
+
+
+
+
+std::string FakeCouchDB::decode( const std::string& s ) {
+    std::string r;
+    r.reserve( s.size() );
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if ( (s[ i ] == '%') && (i + 2 < s.size()) ) {
+            r += static_cast< char >( std::strtol( s.substr( i + 1, 2 ).c_str(), nullptr, 16 ) );
+            i += 2;
+        } else if (s[ i ] == '+') {
+            r += ' ';
+        } else {
+            r += s[ i ];
+        }
+    }
+    return r;
+}
+
+
+
+
+std::string FakeCouchDB::gunzip( const std::string& s ) {
+    z_stream z;
+    std::memset( &z, 0, sizeof( z ) );
+    if (inflateInit2( &z, 16 + MAX_WBITS ) != Z_OK) {
+        throw CouchFine::Exception( "FakeCouchDB: unable to initialize gzip stream" );
+    }
+    z.next_in = reinterpret_cast< Bytef* >( const_cast< char* >( s.data() ) );
+    z.avail_in = static_cast< uInt >( s.size() );
+
+    std::string r;
+    char out[ 64 * 1024 ];
+    int code = Z_OK;
+    while (code == Z_OK) {
+        z.next_out = reinterpret_cast< Bytef* >( out );
+        z.avail_out = sizeof( out );
+        code = inflate( &z, Z_NO_FLUSH );
+        r.append( out, sizeof( out ) - z.avail_out );
+    }
+    inflateEnd( &z );
+    if (code != Z_STREAM_END) {
+        throw CouchFine::Exception( "FakeCouchDB: malformed gzip body" );
+    }
+    return r;
+}
+
+
+
+
+int FakeCouchDB::collate( const CouchFine::Variant& a, const CouchFine::Variant& b ) {
+    const auto rank = [] ( const CouchFine::Variant& v ) -> int {
+        if ( !v || v->empty() ) {
+            return 0;
+        }
+        const std::type_info& t = v->type();
+        if (t == typeid( bool )) {
+            return boost::any_cast< bool >( *v ) ? 2 : 1;
+        }
+        if ( (t == typeid( int )) || (t == typeid( double )) || (t == typeid( long )) || (t == typeid( std::size_t )) ) {
+            return 3;
+        }
+        if (t == typeid( std::string )) {
+            return 4;
+        }
+        return (t == typeid( CouchFine::Array )) ? 5 : 6;
+    };
+
+    const int ra = rank( a );
+    const int rb = rank( b );
+    if (ra != rb) {
+        return (ra < rb) ? -1 : 1;
+    }
+    switch (ra) {
+        case 3 : {
+            const double da = static_cast< double >( a );
+            const double db = static_cast< double >( b );
+            return (da < db) ? -1 : ((db < da) ? 1 : 0);
+        }
+        case 4 :
+            return boost::any_cast< const std::string& >( *a ).compare( boost::any_cast< const std::string& >( *b ) );
+        case 5 : {
+            const CouchFine::Array& la = boost::any_cast< const CouchFine::Array& >( *a );
+            const CouchFine::Array& lb = boost::any_cast< const CouchFine::Array& >( *b );
+            for (std::size_t i = 0; (i < la.size()) && (i < lb.size()); ++i) {
+                const int c = collate( la[ i ], lb[ i ] );
+                if (c != 0) {
+                    return c;
+                }
+            }
+            return (la.size() < lb.size()) ? -1 : ((lb.size() < la.size()) ? 1 : 0);
+        }
+        case 6 :
+            //    :    
+            return toJSON( a ).compare( toJSON( b ) );
+    }
+    return 0;
+}
+
+
+
+
+bool FakeCouchDB::matches( const CouchFine::Object& doc, const CouchFine::Object& selector ) {
+    for (auto itr = selector.cbegin(); itr != selector.cend(); ++itr) {
+        const std::string& name = itr->first;
+        if ( (name == "$and") || (name == "$or") || (name == "$nor") ) {
+            const CouchFine::Array a = boost::any_cast< CouchFine::Array >( *itr->second );
+            std::size_t n = 0;
+            for (auto atr = a.cbegin(); atr != a.cend(); ++atr) {
+                n += matches( doc, boost::any_cast< CouchFine::Object >( **atr ) ) ? 1 : 0;
+            }
+            const bool ok = (name == "$and") ? (n == a.size())
+                : ((name == "$or") ? (n > 0) : (n == 0));
+            if ( !ok ) {
+                return false;
+            }
+            continue;
+        }
+        if (name == "$not") {
+            if ( matches( doc, boost::any_cast< CouchFine::Object >( *itr->second ) ) ) {
+                return false;
+            }
+            continue;
+        }
+        if ( !matchesField( field( doc, name ), itr->second ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+
+bool FakeCouchDB::matchesField( const CouchFine::Variant& value, const CouchFine::Variant& condition ) {
+    const bool present = value && !value->empty();
+    if ( !condition || (condition->type() != typeid( CouchFine::Object )) ) {
+        return present && (collate( value, condition ) == 0);
+    }
+    const CouchFine::Object c = boost::any_cast< CouchFine::Object >( *condition );
+    if ( c.empty() || (c.begin()->first[ 0 ] != '$') ) {
+        //  
+        return present && (value->type() == typeid( CouchFine::Object ))
+            && matches( boost::any_cast< CouchFine::Object >( *value ), c );
+    }
+
+    for (auto itr = c.cbegin(); itr != c.cend(); ++itr) {
+        const std::string& op = itr->first;
+        const CouchFine::Variant& arg = itr->second;
+        bool ok = false;
+        if (op == "$exists") {
+            ok = (present == boost::any_cast< bool >( *arg ));
+        } else if (op == "$not") {
+            ok = !matchesField( value, arg );
+        } else if ( !present ) {
+            ok = (op == "$ne") || (op == "$nin");
+        } else if ( (op == "$in") || (op == "$nin") ) {
+            const CouchFine::Array a = boost::any_cast< CouchFine::Array >( *arg );
+            for (auto atr = a.cbegin(); atr != a.cend(); ++atr) {
+                ok = ok || (collate( value, *atr ) == 0);
+            }
+            ok = (op == "$in") ? ok : !ok;
+        } else if (op == "$regex") {
+            ok = (value->type() == typeid( std::string )) && boost::regex_search(
+                boost::any_cast< std::string >( *value ),
+                boost::regex( boost::any_cast< std::string >( *arg ) )
+            );
+        } else {
+            const int r = collate( value, arg );
+            ok = (op == "$eq")  ? (r == 0)
+               : (op == "$ne")  ? (r != 0)
+               : (op == "$gt")  ? (r > 0)
+               : (op == "$gte") ? (r >= 0)
+               : (op == "$lt")  ? (r < 0)
+               : (op == "$lte") ? (r <= 0)
+               : false;
+        }
+        if ( !ok ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+
+bool FakeCouchDB::merge( CouchFine::Object& target, const CouchFine::Object& source, bool update ) {
+    bool changed = false;
+    for (auto itr = source.cbegin(); itr != source.cend(); ++itr) {
+        if ( (itr->first == "_id") || (itr->first == "_rev") ) {
+            continue;
+        }
+        const auto ftr = target.find( itr->first );
+        const bool objects = (ftr != target.end())
+            && ftr->second && (ftr->second->type() == typeid( CouchFine::Object ))
+            && itr->second && (itr->second->type() == typeid( CouchFine::Object ));
+        if ( objects ) {
+            CouchFine::Object t = boost::any_cast< CouchFine::Object >( *ftr->second );
+            if ( merge( t, boost::any_cast< const CouchFine::Object& >( *itr->second ), update ) ) {
+                ftr->second = typelib::json::cjv( t );
+                changed = true;
+            }
+        } else if ( (ftr == target.end()) || (update && (toJSON( ftr->second ) != toJSON( itr->second ))) ) {
+            target[ itr->first ] = itr->second;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+
+
+
+CouchFine::Variant FakeCouchDB::field( const CouchFine::Object& doc, const std::string& path ) {
+    const std::size_t dot = path.find( '.' );
+    const auto ftr = doc.find( path.substr( 0, dot ) );
+    if (ftr == doc.cend()) {
+        return CouchFine::Variant();
+    }
+    if (dot == std::string::npos) {
+        return ftr->second;
+    }
+    return (ftr->second && (ftr->second->type() == typeid( CouchFine::Object )))
+        ? field( boost::any_cast< const CouchFine::Object& >( *ftr->second ), path.substr( dot + 1 ) )
+        : CouchFine::Variant();
+}
+
+
+
+
+std::map< std::string, std::string >  FakeCouchDB::parseQuery( const std::string& query ) {
+    std::map< std::string, std::string >  r;
+    std::vector< std::string >  pairs;
+    boost::split( pairs, query, boost::is_any_of( "&" ) );
+    for (auto itr = pairs.cbegin(); itr != pairs.cend(); ++itr) {
+        const std::size_t eq = itr->find( '=' );
+        if (eq == std::string::npos) {
+            r[ decode( *itr ) ] = "";
+        } else {
+            r[ decode( itr->substr( 0, eq ) ) ] = decode( itr->substr( eq + 1 ) );
+        }
+    }
+    return r;
+}
+
+
+
+
+CouchFine::Object FakeCouchDB::docObject( const std::string& id, const Doc& doc ) {
+    CouchFine::Object o = doc.body;
+    o[ "_id" ] = typelib::json::cjv( id );
+    o[ "_rev" ] = typelib::json::cjv( doc.rev );
+    if ( !doc.attachments.empty() ) {
+        CouchFine::Object attachments;
+        for (auto itr = doc.attachments.cbegin(); itr != doc.attachments.cend(); ++itr) {
+            CouchFine::Object a;
+            a[ "content_type" ] = typelib::json::cjv( itr->second.first );
+            a[ "length" ] = typelib::json::cjv( static_cast< int >( itr->second.second.size() ) );
+            a[ "stub" ] = typelib::json::cjv( true );
+            attachments[ itr->first ] = typelib::json::cjv( a );
+        }
+        o[ "_attachments" ] = typelib::json::cjv( attachments );
+    }
+    return o;
+}
+
+
+
+
+CouchFine::Object FakeCouchDB::docRow( const std::string& id, const Doc& doc, bool includeDoc ) {
+    CouchFine::Object value;
+    value[ "rev" ] = typelib::json::cjv( doc.rev );
+    if ( doc.deleted ) {
+        value[ "deleted" ] = typelib::json::cjv( true );
+    }
+
+    CouchFine::Object row;
+    row[ "id" ] = typelib::json::cjv( id );
+    row[ "key" ] = typelib::json::cjv( id );
+    row[ "value" ] = typelib::json::cjv( value );
+    if ( includeDoc && !doc.deleted ) {
+        row[ "doc" ] = typelib::json::cjv( docObject( id, doc ) );
+    }
+    return row;
+}
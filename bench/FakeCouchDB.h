@@ -0,0 +1,319 @@
+#pragma once
+
+#include "../include/CouchFine.h"
+#include <map>
+#include <set>
+#include <boost/asio.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+
+/**
+*  (   )   CouchDB.
+*
+*   HTTP API,   :
+*   GET    /
+*   GET    /_all_dbs
+*   GET    /_uuids?count=N
+*   PUT    /db, DELETE /db, GET /db
+*   POST   /db/, PUT /db/id, GET /db/id, DELETE /db/id?rev=
+*   POST   /db/_bulk_docs
+*   GET    /db/_all_docs, POST /db/_all_docs ( 'keys')
+*   GET    /db/_design/d/_view/v (  , . setView())
+*
+*   _all_docs    startkey, endkey,
+* inclusive_end, skip, limit;   -  startkey_docid.
+*     CouchDB,  - .
+*
+*   GET    /_active_tasks (  )
+*   POST   /db/_find -  ($eq, $ne, $gt, $gte, $lt, $lte, $in, $nin,
+*          $exists, $regex, $and, $or, $nor, $not), fields, sort, limit,
+*          skip, bookmark.     .
+*   GET    /db/_index, POST /db/_index
+*   GET    /db/_changes - since, include_docs, limit, feed=longpoll, timeout.
+*             -   .
+*   POST   /db/_bulk_get (   :  )
+*   POST   /db/_design/d/_update/f[/id], PUT -  id. JavaScript  :
+*             ,  Mode::AppendNewOnly
+*          ('mode=update' -  Mode::AppendUpdate).
+*   PUT    /db/id/name, GET /db/id/name, DELETE /db/id/name - 
+*
+*      (Content-Encoding: gzip)  
+*  (Transfer-Encoding: chunked).
+*
+*   ,  ,   ,
+*       .   
+*    CouchDB.
+*
+* @see bench/e2e.cpp
+*/
+
+
+namespace bench {
+
+class FakeCouchDB {
+public:
+    /**
+    *  .
+    */
+    struct Settings {
+        //   , 
+        std::size_t latency;
+
+        //    , [0; jitter] 
+        std::size_t jitter;
+
+        //     , / (0 -  )
+        std::size_t bandwidth;
+
+        //  ,      500, 
+        std::size_t errorRate;
+
+        //   ,   , 
+        std::size_t conflictRate;
+
+        //    design-  setView(), .
+        //     stale=ok / stale=update_after 
+        //  .
+        std::size_t indexTime;
+
+        //   POST /db/_bulk_get (CouchDB 2.x).  - 
+        //  ,  CouchDB 1.x: 405 method_not_allowed.
+        bool bulkGet;
+
+        //     
+        unsigned int seed;
+
+        inline Settings() :
+            latency( 0 ),
+            jitter( 0 ),
+            bandwidth( 0 ),
+            errorRate( 0 ),
+            conflictRate( 0 ),
+            indexTime( 0 ),
+            bulkGet( true ),
+            seed( 5984 )
+        {
+        }
+    };
+
+
+    /**
+    *    127.0.0.1.
+    *
+    * @param port 0 -   .
+    */
+    explicit FakeCouchDB( const Settings& settings = Settings(), unsigned short port = 0 );
+
+    ~FakeCouchDB();
+
+
+    /**
+    * @return    Connection / Communication.
+    */
+    std::string url() const;
+
+
+    /**
+    *  ,    'design/view'  'db'.
+    *   -    'id', 'key', 'value'.
+    *      UID.
+    *  design-  , . Settings::indexTime.
+    */
+    void setView(
+        const std::string& db,
+        const std::string& design,
+        const std::string& view,
+        const CouchFine::Array& rows
+    );
+
+
+    /**
+    *     .
+    */
+    void setSettings( const Settings& settings );
+
+
+    /**
+    * @return   .
+    */
+    std::size_t requests() const;
+
+    /**
+    * @return  ,    .
+    */
+    std::size_t bytesReceived() const;
+
+
+
+
+public:
+    /**
+    *  HTTP-.
+    */
+    struct Request {
+        std::string method;
+        std::string path;
+        std::map< std::string, std::string >  query;
+        std::map< std::string, std::string >  headers;
+        std::string body;
+        //  ,     ( )
+        std::size_t received;
+
+        inline Request() : received( 0 ) {
+        }
+    };
+
+
+    /**
+    * HTTP-.
+    */
+    struct Response {
+        int status;
+        std::string contentType;
+        std::map< std::string, std::string >  headers;
+        std::string body;
+
+        inline Response() : status( 200 ), contentType( "application/json" ) {
+        }
+    };
+
+
+
+
+private:
+    /**
+    *    .
+    */
+    struct Doc {
+        std::size_t generation;
+        //     , . _changes
+        std::size_t seq;
+        std::string rev;
+        CouchFine::Object body;
+        //   -> (content type, )
+        std::map< std::string, std::pair< std::string, std::string > >  attachments;
+        bool deleted;
+
+        inline Doc() : generation( 0 ), seq( 0 ), deleted( false ) {
+        }
+    };
+
+    /**
+    *   design-.
+    */
+    struct Index {
+        bool started;
+        boost::posix_time::ptime start;
+        boost::posix_time::ptime ready;
+
+        inline Index() : started( false ) {
+        }
+    };
+
+    typedef std::map< std::string, Doc >  docs_t;
+    typedef std::map< std::string, docs_t >  dbs_t;
+
+    typedef boost::shared_ptr< boost::asio::ip::tcp::socket >  socket_ptr;
+
+
+    void accept();
+    void serve( socket_ptr socket );
+    bool readRequest( boost::asio::ip::tcp::socket& socket, boost::asio::streambuf& in, Request& request );
+    void writeResponse( boost::asio::ip::tcp::socket& socket, const Response& response );
+
+    Response handle( const Request& request );
+    Response handleDatabase( const Request& request, const std::string& db );
+    Response handleDocument( const Request& request, const std::string& db, const std::string& id );
+    Response handleAttachment( const Request& request, const std::string& db, const std::string& id, const std::string& name );
+    Response handleBulkDocs( const Request& request, const std::string& db );
+    Response handleAllDocs( const Request& request, const std::string& db );
+    Response handleView( const Request& request, const std::string& db, const std::string& design, const std::string& view );
+    Response handleActiveTasks();
+    Response handleUpdate(
+        const Request& request,
+        const std::string& db,
+        const std::string& design,
+        const std::string& handler,
+        const std::string& id
+    );
+    Response handleBulkGet( const Request& request, const std::string& db );
+    Response handleFind( const Request& request, const std::string& db );
+    Response handleChanges( const Request& request, const std::string& db );
+    Response handleIndex( const Request& request, const std::string& db );
+
+    /**
+    *  .   'mutex'.
+    * @return -    CouchDB.
+    */
+    CouchFine::Object writeDoc( docs_t& docs, CouchFine::Object body, bool allowConflict );
+
+    /**
+    *   'mutex'.
+    */
+    std::string nextUID();
+    bool chance( std::size_t perMille );
+
+    static Response json( int status, const CouchFine::Variant& body );
+    static Response error( int status, const std::string& error, const std::string& reason );
+    static std::string toJSON( const CouchFine::Variant& var );
+    static std::string decode( const std::string& s );
+    static std::string gunzip( const std::string& s );
+    static CouchFine::Object docObject( const std::string& id, const Doc& doc );
+    static CouchFine::Object docRow( const std::string& id, const Doc& doc, bool includeDoc );
+    static std::map< std::string, std::string >  parseQuery( const std::string& query );
+
+    /**
+    *      CouchDB:
+    * null < false < true <  <  <  < .
+    * @return <0, 0, >0
+    */
+    static int collate( const CouchFine::Variant& a, const CouchFine::Variant& b );
+
+    /**
+    *    _find.
+    */
+    static bool matches( const CouchFine::Object& doc, const CouchFine::Object& selector );
+    static bool matchesField( const CouchFine::Variant& value, const CouchFine::Variant& condition );
+
+    /**
+    * @return         Variant.
+    */
+    static CouchFine::Variant field( const CouchFine::Object& doc, const std::string& path );
+
+    /**
+    *  'source'  'target'   .
+    * @return true,  'target' .
+    */
+    static bool merge( CouchFine::Object& target, const CouchFine::Object& source, bool update );
+
+
+
+
+private:
+    Settings settings;
+
+    boost::asio::io_service  service;
+    boost::asio::ip::tcp::acceptor  acceptor;
+    boost::thread  acceptThread;
+    boost::thread_group  connections;
+    std::set< socket_ptr >  sockets;
+    bool stopped;
+
+    dbs_t dbs;
+    // db -> "design/view" -> 
+    std::map< std::string, std::map< std::string, CouchFine::Array > >  views;
+    // db -> design -> 
+    std::map< std::string, std::map< std::string, Index > >  indexes;
+    std::size_t uidCounter;
+    std::size_t seqCounter;
+    std::size_t requestCounter;
+    std::size_t bytesCounter;
+    boost::random::mt19937  random;
+
+    mutable boost::mutex  mutex;
+};
+
+
+} // bench
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../include/CouchFine.h"
+#include <boost/lexical_cast.hpp>
+
+
+/**
+*     .
+*/
+
+
+namespace bench {
+
+/**
+*  .
+*/
+struct Shape {
+    //      
+    std::size_t fields;
+
+    //    (0 -  )
+    std::size_t depth;
+
+    //     
+    std::size_t arrayItems;
+
+    //   
+    std::size_t stringLength;
+
+    //  ( )    
+    std::size_t cyrillic;
+
+    //     Mode::File::PREFIX()   
+    std::size_t files;
+
+
+    inline Shape() :
+        fields( 10 ),
+        depth( 1 ),
+        arrayItems( 5 ),
+        stringLength( 16 ),
+        cyrillic( 0 ),
+        files( 0 )
+    {
+    }
+};
+
+
+
+
+/**
+* @return   .     
+*         windows-1251:    Communication::needSafe().
+*/
+inline std::string makeString( std::size_t length, bool cyrillic, std::size_t seed ) {
+    std::string s( length, ' ' );
+    for (std::size_t i = 0; i < length; ++i) {
+        const std::size_t k = (seed + i * 7) % 26;
+        s[ i ] = cyrillic
+            ? static_cast< char >( 0xE0 + k )
+            : static_cast< char >( 'a' + k );
+    }
+    return s;
+}
+
+
+
+
+inline CouchFine::Object makeObject( const Shape& shape, std::size_t level, std::size_t seed ) {
+    CouchFine::Object o;
+    for (std::size_t i = 0; i < shape.fields; ++i) {
+        const std::string field = "f" + boost::lexical_cast< std::string >( i );
+        const std::size_t s = seed * 31 + i;
+        switch (i % 6) {
+            case 0 :
+            case 1 : {
+                const bool cyrillic = ((s % 100) < shape.cyrillic);
+                o[ field ] = typelib::json::cjv( makeString( shape.stringLength, cyrillic, s ) );
+                break;
+            }
+            case 2 :
+                o[ field ] = typelib::json::cjv( static_cast< int >( s % 100000 ) );
+                break;
+            case 3 :
+                o[ field ] = typelib::json::cjv( static_cast< double >( s ) / 7.0 );
+                break;
+            case 4 : {
+                CouchFine::Array a;
+                for (std::size_t k = 0; k < shape.arrayItems; ++k) {
+                    a.push_back( typelib::json::cjv( static_cast< int >( s + k ) ) );
+                }
+                o[ field ] = typelib::json::cjv( a );
+                break;
+            }
+            case 5 :
+                if (level < shape.depth) {
+                    o[ field ] = typelib::json::cjv( makeObject( shape, level + 1, s ) );
+                } else {
+                    o[ field ] = typelib::json::cjv( (s % 2) == 0 );
+                }
+                break;
+        }
+    }
+    return o;
+}
+
+
+
+
+/**
+* @return   :  UID ,  ,  -.
+*/
+inline CouchFine::Object makeDocument( const Shape& shape, std::size_t seed ) {
+    CouchFine::Object o = makeObject( shape, 0, seed );
+    CouchFine::uid( o, "doc-" + boost::lexical_cast< std::string >( seed ) );
+    for (std::size_t i = 0; i < shape.files; ++i) {
+        const std::string name = "attachment" + boost::lexical_cast< std::string >( i ) + ".txt";
+        o[ CouchFine::Mode::File::PREFIX() + name ] =
+            typelib::json::cjv( makeString( shape.stringLength * 4, false, seed + i ) );
+    }
+    return o;
+}
+
+
+
+
+inline std::vector< CouchFine::Object >  makeDocuments( const Shape& shape, std::size_t n ) {
+    std::vector< CouchFine::Object >  docs;
+    docs.reserve( n );
+    for (std::size_t i = 0; i < n; ++i) {
+        docs.push_back( makeDocument( shape, i ) );
+    }
+    return docs;
+}
+
+
+} // bench
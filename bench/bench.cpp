@@ -0,0 +1,336 @@
+#include "Benchmark.h"
+#include "Synthetic.h"
+#include "e2e.h"
+#include "../include/CouchFine.h"
+#include "../external/plustache/include/template.hpp"
+#include "../external/plustache/include/compiled_template.hpp"
+#include <cstdlib>
+#include <new>
+
+
+/**
+*  ""  .  CouchDB  .
+*
+*  ( - ):
+*   --docs N           createBulk (100)
+*   --fields N          (10)
+*   --depth N         (1)
+*   --array N         (5)
+*   --string N        (16)
+*   --cyrillic N       , % (0)
+*   --files N       Mode::File::PREFIX()   (0)
+*   --time N           ,  (500)
+*   --filter S       ,     S
+*
+*     FakeCouchDB:
+*   --e2e 1         (0)
+*   --latency N      ,  (0)
+*   --jitter N      ,  (0)
+*   --bandwidth N   , / (0 -  )
+*   --errors N         500,  (0)
+*   --conflicts N      ,  (0)
+*   --gzip N           N  (0 -  )
+*/
+
+
+namespace bench {
+
+BENCH_THREAD_LOCAL std::size_t allocCount = 0;
+BENCH_THREAD_LOCAL std::size_t allocBytes = 0;
+
+} // bench
+
+
+
+
+void* operator new( std::size_t size ) {
+    ++bench::allocCount;
+    bench::allocBytes += size;
+    void* p = std::malloc( size ? size : 1 );
+    if ( !p ) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+void* operator new[]( std::size_t size ) {
+    return operator new( size );
+}
+
+
+// operator new    malloc(): free()  -  
+#if defined( __GNUC__ ) && (__GNUC__ >= 11)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete( void* p ) throw() {
+    std::free( p );
+}
+
+
+void operator delete[]( void* p ) throw() {
+    std::free( p );
+}
+
+
+#if defined( __cpp_sized_deallocation ) || (__cplusplus >= 201402L)
+void operator delete( void* p, std::size_t ) throw() {
+    std::free( p );
+}
+
+
+void operator delete[]( void* p, std::size_t ) throw() {
+    std::free( p );
+}
+#endif
+
+#if defined( __GNUC__ ) && (__GNUC__ >= 11)
+    #pragma GCC diagnostic pop
+#endif
+
+
+#ifdef __cpp_aligned_new
+//   :  posix_memalign() (
+// _aligned_malloc()  VC),  -  
+void* operator new( std::size_t size, std::align_val_t al ) {
+    ++bench::allocCount;
+    bench::allocBytes += size;
+    void* p = nullptr;
+#ifdef _MSC_VER
+    p = _aligned_malloc( size ? size : 1, static_cast< std::size_t >( al ) );
+#else
+    if (posix_memalign( &p, static_cast< std::size_t >( al ), size ? size : 1 ) != 0) {
+        p = nullptr;
+    }
+#endif
+    if ( !p ) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+void* operator new[]( std::size_t size, std::align_val_t al ) {
+    return operator new( size, al );
+}
+
+
+void operator delete( void* p, std::align_val_t ) throw() {
+#ifdef _MSC_VER
+    _aligned_free( p );
+#else
+    std::free( p );
+#endif
+}
+
+
+void operator delete[]( void* p, std::align_val_t al ) throw() {
+    operator delete( p, al );
+}
+
+
+void operator delete( void* p, std::size_t, std::align_val_t al ) throw() {
+    operator delete( p, al );
+}
+
+
+void operator delete[]( void* p, std::size_t, std::align_val_t al ) throw() {
+    operator delete( p, al );
+}
+#endif
+
+
+
+
+namespace {
+
+struct Options {
+    bench::Shape shape;
+    std::size_t docs;
+    std::size_t time;
+    std::string filter;
+    bool e2e;
+    bench::FakeCouchDB::Settings server;
+    std::size_t gzip;
+
+    inline Options() : docs( 100 ), time( 500 ), e2e( false ), gzip( 0 ) {
+    }
+};
+
+
+
+
+Options parseOptions( int argc, char** argv ) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string key = argv[ i ];
+        const std::string value = argv[ i + 1 ];
+        if (key == "--filter") {
+            opt.filter = value;
+            continue;
+        }
+        const std::size_t n = boost::lexical_cast< std::size_t >( value );
+        if      (key == "--docs")     { opt.docs = n; }
+        else if (key == "--fields")   { opt.shape.fields = n; }
+        else if (key == "--depth")    { opt.shape.depth = n; }
+        else if (key == "--array")    { opt.shape.arrayItems = n; }
+        else if (key == "--string")   { opt.shape.stringLength = n; }
+        else if (key == "--cyrillic") { opt.shape.cyrillic = n; }
+        else if (key == "--files")    { opt.shape.files = n; }
+        else if (key == "--time")     { opt.time = n; }
+        else if (key == "--e2e")      { opt.e2e = (n != 0); }
+        else if (key == "--latency")  { opt.server.latency = n; }
+        else if (key == "--jitter")   { opt.server.jitter = n; }
+        else if (key == "--bandwidth") { opt.server.bandwidth = n; }
+        else if (key == "--errors")   { opt.server.errorRate = n; }
+        else if (key == "--conflicts") { opt.server.conflictRate = n; }
+        else if (key == "--gzip")     { opt.gzip = n; }
+        else {
+            throw CouchFine::Exception( "Unknown option: " + key );
+        }
+    }
+    return opt;
+}
+
+
+
+
+/**
+*     .
+*/
+std::size_t sink = 0;
+
+
+inline void consume( const std::string& s ) {
+    sink += s.size();
+}
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+    try {
+        const Options opt = parseOptions( argc, argv );
+        const auto selected = [ &opt ] ( const std::string& name ) -> bool {
+            return opt.filter.empty() || (name.find( opt.filter ) != std::string::npos);
+        };
+
+        //     
+        const CouchFine::Object doc = bench::makeDocument( opt.shape, 1 );
+        const CouchFine::Variant docVar = typelib::json::cjv( doc );
+        std::ostringstream os;
+        os << docVar;
+        const std::string docJSON = os.str();
+
+        std::vector< CouchFine::Object >  docs = bench::makeDocuments( opt.shape, opt.docs );
+        CouchFine::Pool pool;
+        for (auto itr = docs.begin(); itr != docs.end(); ++itr) {
+            pool << &( *itr );
+        }
+        CouchFine::DocPool docPool( docs.size() );
+        for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+            docPool.push_back( *itr );
+        }
+        CouchFine::Array docsArray;
+        for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+            docsArray.push_back( typelib::json::cjv( *itr ) );
+        }
+
+        const std::string latin = bench::makeString( docJSON.size(), false, 0 );
+        const std::string cyrillic = docJSON + bench::makeString( 16, true, 0 );
+
+        //  :    
+        std::string tmpl = "function( doc ) {\n";
+        PlustacheTypes::ObjectType context;
+        for (std::size_t i = 0; i < opt.shape.fields; ++i) {
+            const std::string field = "f" + boost::lexical_cast< std::string >( i );
+            tmpl += "    if ( doc.{{" + field + "}} ) { emit( doc.{{" + field + "}}, null ); }\n";
+            context[ field ] = field;
+        }
+        tmpl += "}\n";
+
+        CouchFine::Communication comm;
+
+        std::cout << "docJSON: " << docJSON.size() << " bytes, "
+                  << "bulk: " << opt.docs << " docs" << std::endl << std::endl;
+        bench::printHeader( std::cout );
+
+        if ( selected( "printHelper" ) ) {
+            std::cout << bench::run( "printHelper (1 doc)", [ &docVar ] () {
+                std::ostringstream out;
+                CouchFine::printHelper( out, *docVar, "" );
+                consume( out.str() );
+            }, opt.time );
+        }
+
+        if ( selected( "createJSON" ) ) {
+            std::cout << bench::run( "createJSON (bulk array)", [ &docsArray ] () {
+                std::ostringstream out;
+                out << typelib::json::cjv( docsArray );
+                consume( out.str() );
+            }, opt.time );
+        }
+
+        if ( selected( "parseData" ) ) {
+            std::cout << bench::run( "parseData (1 doc)", [ &docJSON ] () {
+                const CouchFine::Variant var = CouchFine::Communication::parseData( docJSON );
+                sink += var ? 1 : 0;
+            }, opt.time );
+        }
+
+        if ( selected( "prepareBulk" ) ) {
+            std::cout << bench::run( "prepareBulk (bulk, file:// filter)", [ &pool ] () {
+                consume( CouchFine::Database::prepareBulk( pool ) );
+            }, opt.time );
+            std::cout << bench::run( "prepareBulk (DocPool, file:// filter)", [ &docPool ] () {
+                consume( CouchFine::Database::prepareBulk( docPool ) );
+            }, opt.time );
+        }
+
+        if ( selected( "needSafe" ) ) {
+            std::cout << bench::run( "needSafe (latin)", [ &latin ] () {
+                sink += CouchFine::Communication::needSafe( latin ) ? 1 : 0;
+            }, opt.time );
+            std::cout << bench::run( "needSafe (cyrillic)", [ &cyrillic ] () {
+                sink += CouchFine::Communication::needSafe( cyrillic ) ? 1 : 0;
+            }, opt.time );
+        }
+
+        if ( selected( "prepareData" ) ) {
+            std::cout << bench::run( "prepareData (RFC1738, cyrillic)", [ &comm, &cyrillic ] () {
+                consume( comm.prepareData( cyrillic ) );
+            }, opt.time );
+        }
+
+        if ( selected( "render" ) ) {
+            template_t t;
+            std::cout << bench::run( "template_t::render", [ &t, &tmpl, &context ] () {
+                consume( t.render( tmpl, context ) );
+            }, opt.time );
+            std::cout << bench::run( "template_t() + render", [ &tmpl, &context ] () {
+                template_t tt;
+                consume( tt.render( tmpl, context ) );
+            }, opt.time );
+            const compiled_template_t compiled( tmpl );
+            std::cout << bench::run( "compiled_template_t::render", [ &compiled, &context ] () {
+                consume( compiled.render( context ) );
+            }, opt.time );
+        }
+
+        if ( opt.e2e ) {
+            bench::runEndToEnd( opt.shape, opt.docs, opt.time, opt.server, opt.filter, opt.gzip );
+        }
+
+        std::cout << std::endl << "(sink " << sink << ")" << std::endl;
+
+    } catch ( const std::exception& ex ) {
+        std::cerr << "Exception: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
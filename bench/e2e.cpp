@@ -0,0 +1,246 @@
+#include "e2e.h"
+#include "Benchmark.h"
+#include <set>
+
+
+namespace bench {
+
+namespace {
+
+/**
+*  'fn',    ,   .
+*/
+template< typename F >
+struct Guarded {
+    F fn;
+    std::size_t* errors;
+
+    inline Guarded( F fn, std::size_t* errors ) : fn( fn ), errors( errors ) {
+    }
+
+    inline void operator()() {
+        try {
+            fn();
+        } catch ( ... ) {
+            ++( *errors );
+        }
+    }
+};
+
+
+template< typename F >
+inline Guarded< F > guarded( F fn, std::size_t* errors ) {
+    return Guarded< F >( fn, errors );
+}
+
+
+
+
+void report( const Result& r, const FakeCouchDB& server, std::size_t requestsBefore, std::size_t bytesBefore, std::size_t errors ) {
+    const double n = static_cast< double >( r.iterations + 1 );
+    std::cout << r
+              << "    requests/op " << static_cast< double >( server.requests() - requestsBefore ) / n
+              << ", upload bytes/op " << static_cast< double >( server.bytesReceived() - bytesBefore ) / n
+              << ", errors " << errors
+              << std::endl;
+}
+
+} // namespace
+
+
+
+
+void runEndToEnd(
+    const Shape& shape,
+    std::size_t n,
+    std::size_t time,
+    const FakeCouchDB::Settings& settings,
+    const std::string& filter,
+    std::size_t gzip
+) {
+    const auto selected = [ &filter ] ( const std::string& name ) -> bool {
+        return filter.empty() || (name.find( filter ) != std::string::npos);
+    };
+
+    //      
+    FakeCouchDB server;
+    CouchFine::Connection conn( server.url() );
+    conn.createDatabase( "bench" );
+    CouchFine::Database store = conn.getDatabase( "bench" );
+
+    std::vector< CouchFine::Object >  docs = makeDocuments( shape, n );
+    std::vector< typelib::uid_t >  uids;
+    CouchFine::Array rows;
+    {
+        CouchFine::Pool pool;
+        for (auto itr = docs.begin(); itr != docs.end(); ++itr) {
+            pool << &( *itr );
+            uids.push_back( CouchFine::uid( *itr ) );
+            CouchFine::Object row;
+            row[ "id" ] = typelib::json::cjv( uids.back() );
+            row[ "key" ] = typelib::json::cjv( uids.back() );
+            row[ "value" ] = typelib::json::cjv( 1 );
+            rows.push_back( typelib::json::cjv( row ) );
+        }
+        CouchFine::Mode::NewUpdate m( pool );
+        store << m;
+    }
+    server.setView( "bench", "bench", "all", rows );
+
+    //  ,       6 :
+    //     
+    CouchFine::Array numericRows;
+    for (std::size_t i = 0; i < n; ++i) {
+        CouchFine::Object row;
+        row[ "id" ] = typelib::json::cjv( uids[ i ] );
+        row[ "key" ] = typelib::json::cjv( (i % 2 == 0)
+            ? 1350000000123.0 + static_cast< double >( i )
+            : 0.1234567 + static_cast< double >( i ) * 1e-7 );
+        row[ "value" ] = typelib::json::cjv( 1 );
+        numericRows.push_back( typelib::json::cjv( row ) );
+    }
+    server.setView( "bench", "bench", "numeric", numericRows );
+
+    //   UID:    
+    std::vector< CouchFine::Object >  fresh = makeDocuments( shape, n );
+    CouchFine::Pool freshPool;
+    for (auto itr = fresh.begin(); itr != fresh.end(); ++itr) {
+        itr->erase( "_id" );
+        freshPool << &( *itr );
+    }
+
+    server.setSettings( settings );
+    CouchFine::Communication& comm = store.getCommunication();
+    if (gzip > 0) {
+        comm.setRequestCompression( true, gzip );
+    }
+    const std::string docURL = "/bench/" + uids.front();
+
+    std::cout << std::endl << "End-to-end (FakeCouchDB at " << server.url() << ", "
+              << "latency " << settings.latency << " ms, jitter " << settings.jitter << " ms, "
+              << "bandwidth " << settings.bandwidth << " B/s, "
+              << "errors " << settings.errorRate << "/1000, conflicts " << settings.conflictRate << "/1000, "
+              << "gzip from " << gzip << " B)"
+              << std::endl << std::endl;
+    printHeader( std::cout );
+
+    if ( selected( "GET" ) ) {
+        std::size_t errors = 0;
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        const Result r = run( "GET document", guarded( [ &comm, &docURL ] () {
+            comm.getData( docURL );
+        }, &errors ), time );
+        report( r, server, r0, b0, errors );
+    }
+
+    if ( selected( "LocalIndex" ) ) {
+        std::size_t errors = 0;
+        //     Communication
+        CouchFine::Connection indexConn( server.url() );
+        CouchFine::Database indexStore = indexConn.getDatabase( "bench" );
+        CouchFine::LocalIndex index( indexStore, [] (
+            const CouchFine::Object& doc,
+            const CouchFine::LocalIndex::fnEmit_t& emit
+        ) {
+            emit( CouchFine::uid( doc ), typelib::json::cjv( CouchFine::revision( doc ) ) );
+        } );
+        index.bootstrap();
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        const std::string& key = uids.front();
+        const Result r = run( "LocalIndex (get, bootstrapped)", guarded( [ &index, &key ] () {
+            if ( !index.get( key ) ) {
+                throw CouchFine::Exception( "Local index: key is missing." );
+            }
+        }, &errors ), time );
+        report( r, server, r0, b0, errors );
+    }
+
+    if ( selected( "Mode::Doc" ) ) {
+        std::size_t errors = 0;
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        const Result r = run( "Mode::Doc (_all_docs keys)", guarded( [ &store, &uids ] () {
+            CouchFine::Mode::Doc doc( uids );
+            store >> doc;
+            if ( !doc.ok ) {
+                throw *doc.exception;
+            }
+        }, &errors ), time );
+        report( r, server, r0, b0, errors );
+    }
+
+    if ( selected( "Mode::View" ) ) {
+        std::size_t errors = 0;
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        const Result r = run( "Mode::View (include_docs)", guarded( [ &store ] () {
+            CouchFine::Mode::View view( "bench", "all", "", true );
+            store >> view;
+            if ( !view.ok ) {
+                throw *view.exception;
+            }
+        }, &errors ), time );
+        report( r, server, r0, b0, errors );
+    }
+
+    if ( selected( "Mode::View" ) ) {
+        std::size_t errors = 0;
+        store.setViewCache( std::make_shared< CouchFine::ViewCache >() );
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        const Result r = run( "Mode::View (ViewCache, 304)", guarded( [ &store ] () {
+            CouchFine::Mode::View view( "bench", "all", "", true );
+            store >> view;
+            if ( !view.ok ) {
+                throw *view.exception;
+            }
+        }, &errors ), time );
+        store.setViewCache( nullptr );
+        report( r, server, r0, b0, errors );
+    }
+
+    if ( selected( "scan" ) ) {
+        std::size_t errors = 0;
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        const std::size_t expected = numericRows.size();
+        const Result r = run( "Database::scan (numeric keys)", guarded( [ &store, expected ] () {
+            CouchFine::Scan scan( "bench", "numeric" );
+            scan.pageSize = 7;
+            scan.partitions = 4;
+            //   -   ;     
+            std::set< typelib::uid_t >  seen;
+            std::size_t delivered = 0;
+            store.scan( scan, [ &seen, &delivered, expected ] ( const CouchFine::Object& row ) -> bool {
+                seen.insert( CouchFine::v< std::string >( row, "id" ) );
+                return ++delivered <= expected;
+            } );
+            if ( (delivered != expected) || (seen.size() != expected) ) {
+                throw CouchFine::Exception( "Scan: rows are lost or repeated." );
+            }
+        }, &errors ), time );
+        report( r, server, r0, b0, errors );
+    }
+
+    if ( selected( "NewOnly" ) ) {
+        std::size_t errors = 0;
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        const Result r = run( "Mode::NewOnly (bulk)", guarded( [ &store, &freshPool ] () {
+            CouchFine::Mode::NewOnly m( freshPool );
+            store << m;
+        }, &errors ), time );
+        report( r, server, r0, b0, errors );
+    }
+
+    if ( selected( "NewUpdate" ) ) {
+        std::size_t errors = 0;
+        const std::size_t r0 = server.requests(), b0 = server.bytesReceived();
+        CouchFine::Pool pool;
+        for (auto itr = docs.begin(); itr != docs.end(); ++itr) {
+            pool << &( *itr );
+        }
+        const Result r = run( "Mode::NewUpdate (bulk, conflicts)", guarded( [ &store, &pool ] () {
+            CouchFine::Mode::NewUpdate m( pool );
+            store << m;
+        }, &errors ), time );
+        report( r, server, r0, b0, errors );
+    }
+}
+
+} // bench
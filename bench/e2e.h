@@ -0,0 +1,27 @@
+#pragma once
+
+#include "FakeCouchDB.h"
+#include "Synthetic.h"
+
+
+namespace bench {
+
+/**
+*  : Communication, Mode::*    
+*  FakeCouchDB.
+*
+* allocs/op  bytes/op -   :  
+*   ,     (. allocCount).
+*
+* @param gzip      ; 0 -  .
+*/
+void runEndToEnd(
+    const Shape& shape,
+    std::size_t docs,
+    std::size_t time,
+    const FakeCouchDB::Settings& settings,
+    const std::string& filter,
+    std::size_t gzip = 0
+);
+
+} // bench
@@ -0,0 +1,98 @@
+/**
+ * @file compiled_template.hpp
+ * @brief header file for precompiled plustache templates
+ */
+#ifndef PLUSTACHE_COMPILED_TEMPLATE_H
+#define PLUSTACHE_COMPILED_TEMPLATE_H
+
+#include "../include/plustache_types.hpp"
+#include "../include/context.hpp"
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+
+/**
+ * @brief template parsed once into a token list
+ *
+ * Parsing uses the same rules as template_t: sections first, then tags,
+ * with partials read and parsed at construction time. Rendering is a
+ * single walk over the tokens, no regex and no disk access.
+ *
+ * Unlike template_t, values and section bodies are inserted literally:
+ * template_t passes them through regex_replace as format strings, which
+ * drops '(' and ')' and expands '$n'.
+ */
+class compiled_template_t {
+  typedef PlustacheTypes::ObjectType ObjectType;
+  typedef PlustacheTypes::CollectionType CollectionType;
+public:
+    explicit compiled_template_t(const std::string& tmplate,
+                                 const std::string& tmpl_path = "");
+    ~compiled_template_t();
+    std::string render(const Context& ctx) const;
+    std::string render(const ObjectType& ctx) const;
+
+private:
+    struct node_t {
+        enum kind_t { TEXT, TAG, RAW_TAG, PARTIAL, SECTION };
+        kind_t kind;
+        /* text or key */
+        std::string text;
+        /* sections: inverted, contains sections */
+        bool inverted;
+        bool nested;
+        std::vector<node_t> children;
+    };
+    /* base context and the collection items entered so far */
+    struct scope_t {
+        const Context* ctx;
+        std::vector<const ObjectType*> items;
+    };
+
+    /* tag and section regex, changed by delimiter tags */
+    struct state_t;
+
+    std::string template_path;
+    std::vector<node_t> nodes;
+
+    void compile_sections(const std::string& tmplate, std::vector<node_t>& out,
+                          state_t& state, size_t depth) const;
+    void compile_tags(const std::string& tmplate, std::vector<node_t>& out,
+                      state_t& state, size_t depth) const;
+    void render_nodes(const std::vector<node_t>& list, const scope_t& scope,
+                      std::string& out) const;
+    static std::string lookup(const scope_t& scope, const std::string& key);
+    static CollectionType collection(const scope_t& scope,
+                                     const std::string& key);
+    static void html_escape(const std::string& s, std::string& out);
+    std::string get_partial(const std::string& partial) const;
+};
+
+
+/**
+ * @brief thread safe cache of compiled templates
+ *
+ * Templates are keyed by their content; a file path is read on every
+ * get(), partials only when the template is compiled. get_string() takes
+ * the content as is and never touches the disk.
+ */
+class template_cache_t {
+  typedef PlustacheTypes::ObjectType ObjectType;
+public:
+    typedef boost::shared_ptr<const compiled_template_t> template_ptr;
+
+    explicit template_cache_t(const std::string& tmpl_path = "");
+    ~template_cache_t();
+    template_ptr get(const std::string& tmplate);
+    template_ptr get_string(const std::string& content);
+    std::string render(const std::string& tmplate, const Context& ctx);
+    std::string render(const std::string& tmplate, const ObjectType& ctx);
+    size_t size() const;
+    void clear();
+
+private:
+    std::string template_path;
+    std::map<std::string, template_ptr> cache;
+    mutable boost::mutex lock;
+};
+#endif
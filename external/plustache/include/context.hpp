@@ -17,6 +17,7 @@ public:
     int add(const std::string& key, const PlustacheTypes::ObjectType& o);
     int add(const PlustacheTypes::ObjectType& o);
     PlustacheTypes::CollectionType get(const std::string& key) const;
+    const PlustacheTypes::CollectionType* find(const std::string& key) const;
 
 private:
     /* data */
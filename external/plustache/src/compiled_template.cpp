@@ -0,0 +1,543 @@
+/**
+ * @file compiled_template.cpp
+ * @brief precompiled plustache templates
+ */
+
+#include "../include/compiled_template.hpp"
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/regex.hpp>
+#include <fstream>
+
+
+namespace {
+
+/* partials including themselves are cut off at this depth */
+const size_t MAX_PARTIAL_DEPTH = 32;
+
+std::string tag_regex(const std::string& otag, const std::string& ctag)
+{
+    return otag + "(#|=|&|!|>|\\{)?(.+?)(\\})?" + ctag;
+}
+
+/**
+ * @brief method to read a whole file
+ *
+ * @return false if the file could not be opened
+ */
+bool read_file(const std::string& path, std::string& ret)
+{
+    std::ifstream file(path.c_str());
+    if (!file.is_open())
+    {
+        return false;
+    }
+    ret.assign((std::istreambuf_iterator<char>(file)),
+                std::istreambuf_iterator<char>());
+    return true;
+}
+
+} // namespace
+
+
+/**
+ * @brief parser state, a delimiter change applies to the rest of the
+ * template
+ */
+struct compiled_template_t::state_t {
+    boost::regex tag;
+    boost::regex section;
+
+    state_t()
+        : tag(tag_regex("\\{\\{", "\\}\\}")),
+          section("\\{\\{(\\^|\\#)([^\\}]*)\\}\\}\\s*(.+?)\\s*\\{\\{/\\2\\}\\}")
+    {
+    }
+};
+
+
+/**
+ * @brief constructor parsing the template
+ *
+ * @param tmplate template as raw std::string
+ * @param tmpl_path path to the template directory (for partials)
+ */
+compiled_template_t::compiled_template_t(const std::string& tmplate,
+                                         const std::string& tmpl_path)
+    : template_path(tmpl_path)
+{
+    state_t state;
+    compile_sections(tmplate, nodes, state, 0);
+}
+
+/**
+ * @brief destructor nothing to do here
+ */
+compiled_template_t::~compiled_template_t()
+{
+
+}
+
+/**
+ * @brief method for rendering the template
+ *
+ * @param ctx context object
+ *
+ * @return rendered std::string
+ */
+std::string compiled_template_t::render(const Context& ctx) const
+{
+    scope_t scope;
+    scope.ctx = &ctx;
+    std::string ret;
+    render_nodes(nodes, scope, ret);
+    return ret;
+}
+
+/**
+ * @brief method for rendering the template
+ *
+ * @param ctx map of values
+ *
+ * @return rendered std::string
+ */
+std::string compiled_template_t::render(const ObjectType& ctx) const
+{
+    Context contxt;
+    contxt.add(ctx);
+    return render(contxt);
+}
+
+/**
+ * @brief method to parse sections, the text around them is parsed for tags
+ *
+ * @param tmplate template std::string to parse
+ * @param out list to append tokens to
+ * @param state parser state
+ * @param depth nesting level of partials
+ */
+void compiled_template_t::compile_sections(const std::string& tmplate,
+                                           std::vector<node_t>& out,
+                                           state_t& state,
+                                           size_t depth) const
+{
+    std::string::const_iterator start = tmplate.begin();
+    const std::string::const_iterator end = tmplate.end();
+    boost::match_results<std::string::const_iterator> matches;
+    while (boost::regex_search(start, end, matches, state.section,
+                               boost::match_default | boost::format_all))
+    {
+        compile_tags(std::string(start, matches[0].first), out, state, depth);
+
+        node_t node;
+        node.kind = node_t::SECTION;
+        node.text.assign(matches[2].first, matches[2].second);
+        std::string modifier(matches[1]);
+        boost::algorithm::trim(node.text);
+        boost::algorithm::trim(modifier);
+        node.inverted = (modifier == "^");
+        const std::string content(matches[3]);
+        node.nested = boost::regex_search(content, state.section,
+                                          boost::match_default | boost::format_all);
+        out.push_back(node);
+        // a section containing sections is not iterated, see
+        // template_t::render_sections()
+        if (node.nested)
+        {
+            compile_sections(content, out.back().children, state, depth);
+        }
+        else
+        {
+            compile_tags(content, out.back().children, state, depth);
+        }
+        start = matches[0].second;
+    }
+    compile_tags(std::string(start, end), out, state, depth);
+}
+
+/**
+ * @brief method to parse tags
+ *
+ * @param tmplate template std::string to parse
+ * @param out list to append tokens to
+ * @param state parser state
+ * @param depth nesting level of partials
+ */
+void compiled_template_t::compile_tags(const std::string& tmplate,
+                                       std::vector<node_t>& out,
+                                       state_t& state,
+                                       size_t depth) const
+{
+    std::string::const_iterator start = tmplate.begin();
+    const std::string::const_iterator end = tmplate.end();
+    boost::match_results<std::string::const_iterator> matches;
+    while (boost::regex_search(start, end, matches, state.tag,
+                               boost::match_default | boost::format_all))
+    {
+        node_t text;
+        text.kind = node_t::TEXT;
+        text.text.assign(start, matches[0].first);
+        if (!text.text.empty())
+        {
+            out.push_back(text);
+        }
+
+        std::string modifier(matches[1].first, matches[1].second);
+        std::string key(matches[2].first, matches[2].second);
+        boost::algorithm::trim(key);
+        boost::algorithm::trim(modifier);
+        node_t node;
+        node.text = key;
+        // don't html escape this
+        if (modifier == "&" || modifier == "{")
+        {
+            node.kind = node_t::RAW_TAG;
+            out.push_back(node);
+        }
+        // this is a comment
+        else if (modifier == "!")
+        {
+        }
+        // found a partial, parse it right away
+        else if (modifier == ">")
+        {
+            node.kind = node_t::PARTIAL;
+            if (depth < MAX_PARTIAL_DEPTH)
+            {
+                state_t partial_state;
+                compile_sections(get_partial(key), node.children,
+                                 partial_state, depth + 1);
+            }
+            out.push_back(node);
+        }
+        // normal tag
+        else
+        {
+            node.kind = node_t::TAG;
+            out.push_back(node);
+        }
+
+        // change delimiter for the rest of the template
+        if (modifier == "=")
+        {
+            boost::regex delim("(.+?) (.+?)=");
+            boost::match_results<std::string::const_iterator> delim_m;
+            if (boost::regex_search(matches[2].first, matches[2].second, delim_m,
+                                    delim, boost::match_default | boost::format_all))
+            {
+                const std::string otag = delim_m[1];
+                const std::string ctag = delim_m[2];
+                state.tag.assign(tag_regex(otag, ctag));
+                state.section.assign(otag + "(\\^|\\#)([^\\}]*)" + ctag +
+                                     "\\s*(.+?)\\s*" + otag + "/\\2" + ctag);
+            }
+        }
+        start = matches[0].second;
+    }
+
+    node_t text;
+    text.kind = node_t::TEXT;
+    text.text.assign(start, end);
+    if (!text.text.empty())
+    {
+        out.push_back(text);
+    }
+}
+
+/**
+ * @brief method to render a token list
+ *
+ * @param list tokens
+ * @param scope context and the collection items entered
+ * @param out std::string to append to
+ */
+void compiled_template_t::render_nodes(const std::vector<node_t>& list,
+                                       const scope_t& scope,
+                                       std::string& out) const
+{
+    for (std::vector<node_t>::const_iterator it = list.begin();
+         it != list.end(); ++it)
+    {
+        switch (it->kind)
+        {
+            case node_t::TEXT:
+                out += it->text;
+                break;
+
+            case node_t::TAG:
+                html_escape(lookup(scope, it->text), out);
+                break;
+
+            case node_t::RAW_TAG:
+                out += lookup(scope, it->text);
+                break;
+
+            case node_t::PARTIAL:
+                render_nodes(it->children, scope, out);
+                break;
+
+            case node_t::SECTION:
+            {
+                // same rules as template_t::render_sections()
+                const CollectionType values = collection(scope, it->text);
+                std::string show = "false";
+                if (values.size() == 1)
+                {
+                    ObjectType::const_iterator found = values[0].find(it->text);
+                    if (found != values[0].end())
+                    {
+                        show = found->second != "" ? found->second : "false";
+                    }
+                    else
+                    {
+                        show = values[0].size() > 0 ? "true" : "false";
+                    }
+                }
+                else if (values.size() > 1)
+                {
+                    show = "true";
+                }
+                if (it->inverted && show == "false") show = "true";
+                else if (it->inverted && show == "true") show = "false";
+                if (show != "true")
+                {
+                    break;
+                }
+                if (it->nested)
+                {
+                    render_nodes(it->children, scope, out);
+                    break;
+                }
+                for (CollectionType::const_iterator vt = values.begin();
+                     vt != values.end(); ++vt)
+                {
+                    scope_t small_scope = scope;
+                    small_scope.items.push_back(&(*vt));
+                    render_nodes(it->children, small_scope, out);
+                }
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief method to get a value, as Context::get(key)[0][key] on the
+ * context with the entered items added
+ *
+ * @param scope context and the collection items entered
+ * @param key
+ *
+ * @return value or empty std::string
+ */
+std::string compiled_template_t::lookup(const scope_t& scope,
+                                        const std::string& key)
+{
+    // Context::add() appends to an existing key, so the outer value wins
+    const CollectionType* c = scope.ctx->find(key);
+    if (c)
+    {
+        if (c->empty())
+        {
+            return "";
+        }
+        ObjectType::const_iterator found = c->front().find(key);
+        return (found == c->front().end()) ? "" : found->second;
+    }
+    for (std::vector<const ObjectType*>::const_iterator it = scope.items.begin();
+         it != scope.items.end(); ++it)
+    {
+        ObjectType::const_iterator found = (*it)->find(key);
+        if (found != (*it)->end())
+        {
+            return found->second;
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief method to get a collection, as Context::get(key) on the context
+ * with the entered items added
+ *
+ * @param scope context and the collection items entered
+ * @param key
+ *
+ * @return collection for the keyword
+ */
+PlustacheTypes::CollectionType compiled_template_t::collection(
+    const scope_t& scope, const std::string& key)
+{
+    CollectionType ret;
+    const CollectionType* c = scope.ctx->find(key);
+    if (c)
+    {
+        ret = *c;
+    }
+    for (std::vector<const ObjectType*>::const_iterator it = scope.items.begin();
+         it != scope.items.end(); ++it)
+    {
+        ObjectType::const_iterator found = (*it)->find(key);
+        if (found != (*it)->end())
+        {
+            ObjectType o;
+            o[key] = found->second;
+            ret.push_back(o);
+        }
+    }
+    if (!c && ret.empty())
+    {
+        ObjectType o;
+        o[key] = "";
+        ret.push_back(o);
+    }
+    return ret;
+}
+
+/**
+ * @brief method to escape html std::strings
+ *
+ * @param s std::string to escape
+ * @param out std::string to append to
+ */
+void compiled_template_t::html_escape(const std::string& s, std::string& out)
+{
+    for (std::string::const_iterator it = s.begin(); it != s.end(); ++it)
+    {
+        switch (*it)
+        {
+            case '&':  out += "&amp;";  break;
+            case '<':  out += "&lt;";   break;
+            case '>':  out += "&gt;";   break;
+            case '\\': out += "&#92;";  break;
+            case '"':  out += "&quot;"; break;
+            default:   out += *it;
+        }
+    }
+}
+
+/**
+ * @brief method to load partial template from file
+ *
+ * @param partial name of the partial to load
+ *
+ * @return partial template as std::string
+ */
+std::string compiled_template_t::get_partial(const std::string& partial) const
+{
+    std::string ret = "";
+    if (!read_file(template_path + partial + ".mustache", ret))
+    {
+        read_file(partial, ret);
+    }
+    return ret;
+}
+
+
+/**
+ * @brief constructor
+ *
+ * @param tmpl_path path to the template directory
+ */
+template_cache_t::template_cache_t(const std::string& tmpl_path)
+    : template_path(tmpl_path)
+{
+
+}
+
+/**
+ * @brief destructor nothing to do here
+ */
+template_cache_t::~template_cache_t()
+{
+
+}
+
+/**
+ * @brief method to get a compiled template, compiling it on first use
+ *
+ * @param tmplate template as raw std::string or file path
+ *
+ * @return compiled template
+ */
+template_cache_t::template_ptr template_cache_t::get(const std::string& tmplate)
+{
+    // same lookup as template_t::get_template()
+    std::string tmp;
+    if (!read_file(tmplate, tmp) && !read_file(template_path + tmplate, tmp))
+    {
+        tmp = tmplate;
+    }
+    return get_string(tmp);
+}
+
+/**
+ * @brief method to get a compiled template from its content, without
+ * trying to read it as a file
+ *
+ * @param content template as raw std::string
+ *
+ * @return compiled template
+ */
+template_cache_t::template_ptr template_cache_t::get_string(
+    const std::string& content)
+{
+    {
+        boost::mutex::scoped_lock guard(lock);
+        std::map<std::string, template_ptr>::const_iterator it = cache.find(content);
+        if (it != cache.end())
+        {
+            return it->second;
+        }
+    }
+
+    // compile outside the lock, the first one stored wins
+    template_ptr compiled(new compiled_template_t(content, template_path));
+    boost::mutex::scoped_lock guard(lock);
+    return cache.insert(std::make_pair(content, compiled)).first->second;
+}
+
+/**
+ * @brief method for rendering a template
+ *
+ * @param tmplate template to render as raw std::string or file path
+ * @param ctx context object
+ *
+ * @return rendered std::string
+ */
+std::string template_cache_t::render(const std::string& tmplate,
+                                     const Context& ctx)
+{
+    return get(tmplate)->render(ctx);
+}
+
+/**
+ * @brief method for rendering a template
+ *
+ * @param tmplate template to render as raw std::string or file path
+ * @param ctx map of values
+ *
+ * @return rendered std::string
+ */
+std::string template_cache_t::render(const std::string& tmplate,
+                                     const ObjectType& ctx)
+{
+    return get(tmplate)->render(ctx);
+}
+
+/**
+ * @brief method to get the number of cached templates
+ */
+size_t template_cache_t::size() const
+{
+    boost::mutex::scoped_lock guard(lock);
+    return cache.size();
+}
+
+/**
+ * @brief method to drop all cached templates
+ */
+void template_cache_t::clear()
+{
+    boost::mutex::scoped_lock guard(lock);
+    cache.clear();
+}
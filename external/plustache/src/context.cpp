@@ -130,3 +130,17 @@ PlustacheTypes::CollectionType Context::get(const std::string& key) const
   }
   return ret;
 }
+
+/**
+ * @brief method to look up a keyword without copying its collection
+ *
+ * @param key
+ *
+ * @return collection for the keyword or NULL if it wasn't found
+ */
+const PlustacheTypes::CollectionType* Context::find(const std::string& key) const
+{
+  std::map<std::string, PlustacheTypes::CollectionType> :: const_iterator it;
+  it = ctx.find(key);
+  return (it == ctx.end()) ? NULL : &it->second;
+}
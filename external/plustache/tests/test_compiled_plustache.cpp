@@ -0,0 +1,140 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <gtest/gtest.h>
+
+#include "include/template.hpp"
+#include "include/compiled_template.hpp"
+#include "include/plustache_types.hpp"
+
+// The fixture for testing class compiled_template_t.
+class CompiledTest : public ::testing::Test
+{
+ protected:
+    std::string template_string;
+    std::string partial_file;
+    PlustacheTypes::ObjectType ctx;
+    Context people_ctx;
+
+    CompiledTest()
+    {
+    }
+
+    virtual ~CompiledTest()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        template_string = "Hi I am {{name}}.\n";
+        template_string += "{{# showme}}";
+        template_string += "I like {{pet}}.";
+        template_string += "{{/ showme}}";
+        template_string += "{{^ showme}}";
+        template_string += "If you see this, something went wrong.";
+        template_string += "{{/ showme}}";
+        template_string += "{{! comment }}";
+        template_string += "{{> next_more}}\n";
+        template_string += "{{ title }} {{{ title }}} {{& title }}";
+
+        partial_file = "next_more.mustache";
+        std::ofstream myfile;
+        myfile.open (partial_file.c_str());
+        myfile << "What do I like? {{lpet}}!!";
+        myfile.close();
+
+        ctx["name"] = "Daniel";
+        ctx["pet"] = "turtles";
+        ctx["lpet"] = "Turtles";
+        ctx["showme"] = "true";
+        ctx["title"] = "<b>";
+
+        PlustacheTypes::ObjectType tom;
+        PlustacheTypes::ObjectType jerry;
+        tom["name"] = "Tom";
+        jerry["name"] = "Jerry";
+        PlustacheTypes::CollectionType people;
+        people.push_back(tom);
+        people.push_back(jerry);
+        people_ctx.add("me", "Daniel");
+        people_ctx.add("people", people);
+    }
+
+    virtual void TearDown()
+    {
+        remove(partial_file.c_str());
+    }
+
+};
+
+// Tests that a compiled template renders the same as template_t
+TEST_F(CompiledTest, TestCompiledSameAsTemplate)
+{
+    template_t t;
+    compiled_template_t c(template_string);
+    std::string expected = "Hi I am Daniel.\n";
+          expected += "I like turtles.";
+          expected += "What do I like? Turtles!!\n";
+          expected += "&lt;b&gt; <b> <b>";
+    EXPECT_EQ(expected, c.render(ctx));
+    EXPECT_EQ(t.render(template_string, ctx), c.render(ctx));
+}
+
+TEST_F(CompiledTest, TestCompiledCollections)
+{
+    // whitespace around a section body is dropped, as in template_t
+    compiled_template_t c("{{me}}: {{# people}} Hi {{name}}! {{/ people}}");
+    EXPECT_EQ("Daniel: Hi Tom!Hi Jerry!", c.render(people_ctx));
+}
+
+// Tests that a compiled template can be rendered with another context
+TEST_F(CompiledTest, TestCompiledRenderTwice)
+{
+    compiled_template_t c(template_string);
+    const std::string first = c.render(ctx);
+    ctx["name"] = "Tom";
+    ctx["showme"] = "false";
+    std::string expected = "Hi I am Tom.\n";
+          expected += "If you see this, something went wrong.";
+          expected += "What do I like? Turtles!!\n";
+          expected += "&lt;b&gt; <b> <b>";
+    EXPECT_EQ(expected, c.render(ctx));
+    EXPECT_NE(first, c.render(ctx));
+}
+
+// Tests that parentheses and '$' are kept, template_t drops them
+TEST_F(CompiledTest, TestCompiledLiteralText)
+{
+    compiled_template_t c("{{# showme}}emit( doc.{{field}}, null );{{/ showme}}");
+    ctx["field"] = "f($1)";
+    EXPECT_EQ("emit( doc.f($1), null );", c.render(ctx));
+}
+
+TEST_F(CompiledTest, TestCompiledChangeDelimiter)
+{
+    compiled_template_t c("Hi I am {{name}}.\n{{=<% %>=}}I like <%pet%>.");
+    EXPECT_EQ("Hi I am Daniel.\nI like turtles.", c.render(ctx));
+}
+
+// Tests that the cache compiles a template once
+TEST_F(CompiledTest, TestCache)
+{
+    template_cache_t cache;
+    template_cache_t::template_ptr a = cache.get(template_string);
+    template_cache_t::template_ptr b = cache.get(template_string);
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_EQ(1u, cache.size());
+    EXPECT_EQ(a->render(ctx), cache.render(template_string, ctx));
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+}
+
+// Tests that content is never taken for a file name
+TEST_F(CompiledTest, TestCacheString)
+{
+    template_cache_t cache;
+    template_cache_t::template_ptr a = cache.get_string(template_string);
+    EXPECT_EQ(a.get(), cache.get(template_string).get());
+    EXPECT_EQ(a->render(ctx), cache.render(template_string, ctx));
+    EXPECT_EQ("tests.cpp", cache.get_string("tests.cpp")->render(ctx));
+}
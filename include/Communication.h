@@ -1,10 +1,17 @@
 #pragma once
 
 #include "type.h"
+#include "Deadline.h"
 #include "Exception.h"
+#include <cstdlib>
 #include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
 #include <boost/algorithm/string.hpp>
 #include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <boost/random/mersenne_twister.hpp>
 
 
 /**
@@ -45,10 +52,30 @@ inline void transformObject( Variant* var ) {
 
 
 
+/**
+*    : 15 ,   ,  
+*  ,  - 17.     (6)  
+*     .
+*/
+inline void printDouble( std::ostream& out, double x ) {
+    std::ostringstream ostr;
+    ostr.precision( 15 );
+    ostr << x;
+    if (std::strtod( ostr.str().c_str(), nullptr ) != x) {
+        ostr.str( "" );
+        ostr.precision( 17 );
+        ostr << x;
+    }
+    out << ostr.str();
+}
+
+
+
 inline void printHelper( std::ostream& out, const boost::any& value, const std::string& indent ) {
    std::string childIndent = indent + "   ";
 
-   boost::any val = value;
+   //  :     
+   const boost::any& val = value;
 
    if ( val.empty() )
       out << "null";
@@ -73,9 +100,10 @@ inline void printHelper( std::ostream& out, const boost::any& value, const std::
       if (type == typeid( const char* ))
           out << '"' << boost::any_cast< const char* >( val ) << '"';
       else if (type == typeid( std::string ))
-          out << '"' << boost::any_cast< std::string >( val ) << '"';
+          out << '"' << *boost::any_cast< std::string >( &val ) << '"';
       else if (type == typeid( bool ))
-          out << boost::any_cast< bool >( val );
+          // JSON   true / false,  1 / 0
+          out << ( boost::any_cast< bool >( val ) ? "true" : "false" );
       else if (type == typeid( int ))
           out << boost::any_cast< int >( val );
       else if (type == typeid( size_t ))
@@ -83,9 +111,9 @@ inline void printHelper( std::ostream& out, const boost::any& value, const std::
       else if (type == typeid( long ))
           out << boost::any_cast< long >( val );
       else if (type == typeid( float ))
-          out << boost::any_cast< float >( val );
+          printDouble( out, boost::any_cast< float >( val ) );
       else if (type == typeid( double ))
-          out << boost::any_cast< double >( val );
+          printDouble( out, boost::any_cast< double >( val ) );
       else if (type == typeid( char ))
           out << boost::any_cast< char >( val );
       else if (type == typeid( unsigned char ))
@@ -98,8 +126,8 @@ inline void printHelper( std::ostream& out, const boost::any& value, const std::
       // @see Pool& operator<<( Pool&, Object* )
       else if ( (type == typeid( Object )) || (type == typeid( Object* )) ) {
 
-         const Object obj = (type == typeid( Object ))
-             ? boost::any_cast< Object >( val )
+         const Object& obj = (type == typeid( Object ))
+             ? *boost::any_cast< Object >( &val )
              : *boost::any_cast< Object* >( val );
 
          out << "{";
@@ -132,7 +160,7 @@ inline void printHelper( std::ostream& out, const boost::any& value, const std::
          out << "}";
       }
       else if(type == typeid(Array)) {
-         Array array = boost::any_cast<Array>(value);
+         const Array& array = *boost::any_cast< Array >( &value );
 
          out << "[";
 #ifdef COUCHFINE_DEBUG
@@ -140,8 +168,8 @@ inline void printHelper( std::ostream& out, const boost::any& value, const std::
 #endif
 
          bool addComma = false;
-         Array::iterator        data     = array.begin();
-         const Array::iterator &data_end = array.end();
+         Array::const_iterator        data     = array.begin();
+         const Array::const_iterator &data_end = array.end();
          for( ; data != data_end; ++data) {
             if ( addComma ) {
                out << ", ";
@@ -184,6 +212,66 @@ inline void printHelper( std::ostream& out, const CouchFine::Object& obj, const
 
 
 
+/**
+*    (hedging)   (GET, HEAD).
+*
+*      /    5xx,
+*  ,    [0; min(maxDelay, baseDelay * 2^n)].
+*      :   
+*   'budgetRatio',      1.  
+*          'maxAttempts' .
+*
+*  -    GET   ,  
+*     'hedgePercentile'  . 
+* ,  .     .
+*/
+struct RetryPolicy {
+    //  ,   (1 -  )
+    size_t maxAttempts;
+
+    //       , 
+    size_t baseDelay;
+    size_t maxDelay;
+
+    //        
+    double budgetRatio;
+    double budgetMax;
+
+    //   GET
+    bool hedge;
+
+    //       [0; 1]  ...
+    double hedgePercentile;
+
+    // ...  , 
+    size_t hedgeMinDelay;
+
+    //   ,   
+    size_t hedgeMinSamples;
+
+
+    inline RetryPolicy() :
+        maxAttempts( 3 ),
+        baseDelay( 50 ),
+        maxDelay( 1000 ),
+        budgetRatio( 0.1 ),
+        budgetMax( 10.0 ),
+        hedge( false ),
+        hedgePercentile( 0.95 ),
+        hedgeMinDelay( 10 ),
+        hedgeMinSamples( 20 )
+    {
+    }
+};
+
+
+
+
+
+
+class Singleflight;
+
+
 class Communication {
 public:
     /**
@@ -205,8 +293,50 @@ public:
 #endif
 
 
+      /**
+      *   HTTP.
+      */
+      enum Protocol {
+          HTTP_1_1,
+          // HTTP/2  TLS (ALPN);  TLS   
+          //   - HTTP/1.1
+          HTTP_2_TLS,
+          // HTTP/2  TLS (h2c),    HTTP/2 .
+          // , h2-  CouchDB.
+          HTTP_2_PRIOR_KNOWLEDGE
+      };
+
+
+      /**
+      *   getDataBatch().
+      */
+      struct Request {
+          std::string url;
+          std::string method;
+          std::string data;
+
+          inline Request(
+              const std::string& url,
+              const std::string& method = "GET",
+              const std::string& data = ""
+          ) : url( url ), method( method ), data( data ) {
+          }
+      };
+
+
       Communication();
       Communication(const std::string&);
+
+      /**
+      *   Unix-,   TCP.  CouchDB  ,
+      *     .
+      *
+      * @param url  .     Host
+      *          ,  "http://localhost:5984".
+      * @param unixSocket   ,  "/var/run/couchdb.sock".
+      */
+      Communication( const std::string& url, const std::string& unixSocket );
+
       ~Communication();
 
       Variant getData(const std::string&, const std::string& method = "GET",
@@ -217,11 +347,217 @@ public:
 
       std::string getRawData(const std::string&);
 
+      /**
+      * GET  .   -  ,  : 
+      *   ,  304  If-None-Match.
+      *
+      * @see responseStatus()
+      */
+      std::string getRawData( const std::string& url, const HeaderMap& headers );
+
+
+      /**
+      * @return   HTTP    getData() / getRawData().
+      *         0 -   .
+      */
+      long responseStatus() const;
+
+
+      /**
+      * @return      getData() / getRawData().
+      *          -   : "etag", "content-type".
+      */
+      const HeaderMap& responseHeaders() const;
+
+
+      /**
+      *   ,   'concurrency'  .
+      *  HTTP/2     ,  HTTP/1.1 -
+      *    .
+      *
+      * @return    .      
+      *         ,   -    'error' 
+      *         'reason',    CouchDB.   .
+      *
+      * @see setProtocol()
+      */
+      std::vector< Variant >  getDataBatch(
+          const std::vector< Request >& requests,
+          size_t concurrency = 16
+      );
+
+
+      void setProtocol( Protocol );
+
+
+      /**
+      *  (gzip)     'threshold' .
+      *     ,     .
+      *   createBulk(), flush()  ..   .
+      *    getDataBatch(): deleteBulk(), bulkGet()  .
+      *
+      * (!)    'Content-Encoding: gzip'  .
+      * CouchDB ,   1.x;    -  .
+      *
+      * @param level   zlib: 1 - , 9 - .
+      */
+      void setRequestCompression( bool enable, size_t threshold = 64 * 1024, int level = 6 );
+
+
+      /**
+      *    GET / HEAD   
+      * Communication,    'group'. nullptr -  .
+      *
+      * @see Singleflight
+      */
+      void setSingleflight( std::shared_ptr< Singleflight > group );
+
+      std::shared_ptr< Singleflight > singleflight() const;
+
+
+      /**
+      *      JSON.
+      */
+      static Variant parseData( const std::string& buffer );
+
+
+      /**
+      * @return true,      
+      *          (  ).
+      */
+      static bool needSafe( const std::string& data );
+
+
+      /**
+      * @return ,    .
+      *
+      * @see needSafe()
+      * @see FROM_RFC1738
+      */
+      std::string prepareData( const std::string& data ) const;
+
+
+      /**
+      *   .   .
+      */
+      void setRetryPolicy( const RetryPolicy& );
+
+      const RetryPolicy& retryPolicy() const;
+
+
+      /**
+      *         
+      * .   DeadlineScope.
+      *
+      *        (10 ).
+      *      ,  
+      *   .
+      */
+      void setDeadline( const Deadline& );
+
+      const Deadline& deadline() const;
+
+
+      /**
+      *       .
+      *   .
+      *
+      * :
+      *   Communication::DeadlineScope scope( db.getCommunication(), Deadline( 300 ) );
+      *   const Document doc = db.getDocument( "a" );
+      */
+      class DeadlineScope {
+      public:
+          inline DeadlineScope( Communication& comm, const Deadline& deadline ) :
+              comm( comm ), previous( comm.deadline() )
+          {
+              comm.setDeadline( deadline );
+          }
+
+          /**
+          *  'deadline'  ,   .
+          */
+          inline DeadlineScope( Communication& comm, const boost::optional< Deadline >& deadline ) :
+              comm( comm ), previous( comm.deadline() )
+          {
+              if ( deadline ) {
+                  comm.setDeadline( *deadline );
+              }
+          }
+
+          inline ~DeadlineScope() {
+              comm.setDeadline( previous );
+          }
+
+      private:
+          DeadlineScope( const DeadlineScope& );
+          DeadlineScope& operator=( const DeadlineScope& );
+
+          Communication& comm;
+          const Deadline previous;
+      };
+
 
 
 
    private:
-      void init(const std::string&);
+      void init( const std::string& url, const std::string& unixSocket = "" );
+
+      /**
+      *    'curl' ,  
+      *    'hedgeCurl'.
+      *
+      * @param status   HTTP.
+      */
+      CURLcode perform( const std::string& url, bool hedge, long* status );
+
+      /**
+      * @param delay       .
+      */
+      CURLcode performHedged( const std::string& url, double delay, long* status );
+
+      /**
+      * @return true,     .
+      */
+      static bool retryable( CURLcode result, long status );
+
+      /**
+      *     .
+      * @return false,   .
+      */
+      bool takeRetryToken();
+
+      /**
+      * @return      'attempt' ( 0), .
+      */
+      size_t backoff( size_t attempt );
+
+      /**
+      *       .
+      */
+      void addLatency( double ms );
+
+      /**
+      * @return    , . 0 -  .
+      */
+      double hedgeDelay() const;
+
+      /**
+      * @return       , .
+      */
+      long timeout() const;
+
+      /**
+      *  ,      .
+      */
+      void checkDeadline( const std::string& url ) const;
+
+      /**
+      *   'curl',     
+      *   .
+      */
+      void resetCopies();
+
       Variant getData(const std::string&, const std::string&,
                       std::string, const HeaderMap&);
       void getRawData(const std::string&, const std::string&,
@@ -290,6 +626,37 @@ public:
       CURL*       curl;
       std::string baseURL;
       std::string buffer;
+
+      //    , . responseStatus()
+      long        lastStatus;
+      HeaderMap   lastHeaders;
+
+      //  :  ,  
+      CURL*       hedgeCurl;
+      CURLM*      multi;
+      std::string hedgeBuffer;
+      HeaderMap   hedgeHeaders;
+
+      //  , . getDataBatch()
+      CURLM*      batchMulti;
+      std::vector< CURL* >  batchCurl;
+
+      //  , . setRequestCompression()
+      bool        compressRequests;
+      size_t      compressThreshold;
+      int         compressLevel;
+
+      //   , . setSingleflight()
+      std::shared_ptr< Singleflight >  flightGroup;
+
+      RetryPolicy policy;
+      double      retryTokens;
+      Deadline    currentDeadline;
+      boost::random::mt19937  random;
+
+      //    GET, ;  
+      std::vector< double >  latencies;
+      size_t      latencyPos;
 };
 
 
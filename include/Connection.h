@@ -15,6 +15,11 @@ class Connection{
    public:
       Connection();
       Connection(const std::string&);
+
+      /**
+      * @see Communication( const std::string& url, const std::string& unixSocket )
+      */
+      Connection( const std::string& url, const std::string& unixSocket );
       ~Connection();
 
       std::string getCouchDBVersion() const;
@@ -39,6 +44,23 @@ class Connection{
 
 
 
+      /**
+      *    .   (
+      * design-, , ,  design-.)
+      *     .
+      *
+      * (!)      ,    :
+      *  std::string "Database '...' not found.",   .
+      *       : 
+      *       design-,
+      *   Exception   .
+      *
+      * @see clearDatabase()
+      */
+      void clearDatabases( const std::vector< std::string >&  names, bool includeDesign );
+
+
+
    private:
       void init( const std::string& );
       void getInfo();
@@ -12,7 +12,10 @@
 #include "Connection.h"
 #include "View.h"
 #include "Database.h"
+#include "DesignSync.h"
+#include "LocalIndex.h"
 #include "Pool.h"
+#include "Singleflight.h"
 
 
 namespace CouchFine {
@@ -69,6 +72,19 @@ CouchFine::Database& operator>>(
 
 
 
+/**
+*    _find.     'find' 
+*  .
+*/
+CouchFine::Database& operator>>(
+    CouchFine::Database& store,
+    CouchFine::Mode::Find& find
+);
+
+
+
+
+
 
 
 
@@ -125,6 +141,17 @@ CouchFine::Database& operator<<(
 
 
 
+
+CouchFine::Database& operator<<(
+    CouchFine::Database& store,
+    CouchFine::Mode::NewSkipMany& doc
+);
+
+
+
+
+
+
 CouchFine::Database& operator<<(
     CouchFine::Database& store,
     CouchFine::Mode::File& file
@@ -144,8 +171,30 @@ CouchFine::Database& operator<<(
 
 
 
+/**
+* UID     .
+*
+* @see Mode::AppendNewOnly
+*/
+CouchFine::Database& operator<<(
+    CouchFine::Database& store,
+    CouchFine::Mode::AppendNewOnly& doc
+);
+
+
+
+CouchFine::Database& operator<<(
+    CouchFine::Database& store,
+    CouchFine::Mode::AppendUpdate& doc
+);
+
+
+
+
+
+
 #if 0
-// - @todo ...
+// -  ,  . . . .
 inline CouchFine::Database& operator<<(
     CouchFine::Database& store,
     const CouchFine::Mode::AppendNewOnly& doc
@@ -2,6 +2,9 @@
 
 #include "configure.h"
 #include "Document.h"
+#include "Mode.h"
+#include "Scan.h"
+#include "ViewCache.h"
 
 
 namespace CouchFine {
@@ -79,6 +82,28 @@ class Database {
 
 
       
+      /**
+      *      _bulk_get:   
+      *   'batchSize' ,  - .  
+      * _bulk_get (CouchDB 1.x,  404  405)    
+      * .    -    .
+      *
+      * @param docs  (UID, ).   - .
+      * @param revs      ('_revisions').
+      * @param concurrency    _bulk_get.
+      *
+      * @return    'docs':    
+      *          'id', 'rev', 'error', 'reason'.
+      */
+      CouchFine::Array bulkGet(
+          const std::vector< uidrev_t >&  docs,
+          bool revs = false,
+          size_t batchSize = 500,
+          size_t concurrency = 4
+      );
+
+
+
       /**
       * @param key   . :
       *            (1) startkey="_design/a"&endkey="_design/{"
@@ -93,6 +118,25 @@ class Database {
 
 
 
+      /**
+      *    getView() ( Mode::View).   -
+      * , design-,    
+      *   .
+      *     Database  . nullptr -  .
+      *
+      * @see ViewCache
+      */
+      inline void setViewCache( std::shared_ptr< ViewCache > cache ) {
+          viewCache = cache;
+      }
+
+
+      inline std::shared_ptr< ViewCache > getViewCache() const {
+          return viewCache;
+      }
+
+
+
       inline bool hasView( const std::string& viewName, const std::string& designName = "" ) {
         // @todo optimize?
         const std::string designUID = getDesignUID( designName );
@@ -132,6 +176,40 @@ class Database {
       );
 
 
+      /**
+      * @return    _bulk_docs   . 
+      *           Mode::File::PREFIX()    .
+      *
+      * @see createBulk( const CouchFine::Array& )
+      */
+      static std::string prepareBulk(
+          const CouchFine::Array& docs,
+          CouchFine::fnCreateJSON_t fnCreateJSON = fnCreateJSON_t()
+      );
+
+
+      /**
+      *  ,  createBulk( const Array& ),    DocPool.
+      *    (DocPool::borrow())   
+      *  _id  _rev.
+      */
+      CouchFine::Array createBulk(
+          CouchFine::DocPool& docs,
+          CouchFine::fnCreateJSON_t fnCreateJSON = fnCreateJSON_t()
+      );
+
+
+      /**
+      *  ,  prepareBulk( const Array& ).  'fnCreateJSON' 
+      *     ,  Mode::File::PREFIX() 
+      *  :   .
+      */
+      static std::string prepareBulk(
+          const CouchFine::DocPool& docs,
+          CouchFine::fnCreateJSON_t fnCreateJSON = fnCreateJSON_t()
+      );
+
+
       /**
       *          flush().
       *       .
@@ -155,6 +233,64 @@ class Database {
       void createBulk( const std::string& doc );
 
 
+      /**
+      *    :   UID - 
+      *   (createBulk( DocPool& ))  
+      * (operator>>( Object& ), Mode::Doc)    .
+      * Mode::NewUpdate   ,  
+      *  :   ,   .
+      *
+      *       Database. 'on' == false - .
+      * (!) ,     ( ), 
+      *      : ,   ,   .
+      *
+      * #       _rev   
+      *   ,  _id  _deleted.   
+      *   Mode::File::PREFIX()  .
+      */
+      void trackDigests( bool on = true );
+
+
+      inline bool tracksDigests() const {
+          return (bool)digests;
+      }
+
+
+      /**
+      * @return  ,      'doc'
+      *            .  -  .
+      */
+      rev_t unchanged( const Object& doc ) const;
+
+
+      /**
+      *     UID  .
+      * @see trackDigests()
+      */
+      void remember( const Object& doc );
+
+
+      /**
+      *   'acc'    'doc'    UID.
+      */
+      typedef boost::function< void( Object& acc, const Object& doc ) >  fnMerge_t;
+
+
+      /**
+      *       createBulk( const Object& ).
+      *      UID    : 
+      * ,   'fnMerge',   .  
+      *    .
+      *
+      *     .      _bulk_docs,
+      *  ,  ,   .
+      *
+      * #     UID:   UID 
+      *    UID      .
+      */
+      void coalesce( bool on = true, fnMerge_t fnMerge = fnMerge_t() );
+
+
       /**
       *      .  .
       *
@@ -171,8 +307,61 @@ class Database {
 
 
 
+      /**
+      *   .   :   
+      * _all_docs  ,     _bulk_docs.
+      *        
+      * .
+      *
+      * @return    'ids':    'id', 'rev'
+      *          'id', 'error', 'reason'. ,  
+      *            ,   'conflict'.
+      */
+      CouchFine::Array deleteBulk(
+          const std::vector< uid_t >&  ids,
+          size_t batchSize = 1000
+      );
+
+
+
+      /**
+      *  .  false -   .
+      *         '_id':
+      *   ,  .
+      *
+      * (!)     ,   
+      *  .      .
+      */
+      typedef boost::function< bool( Object& doc ) >  fnModify_t;
+
+
+      /**
+      *  -  -   .  
+      *    _all_docs,     _bulk_docs.
+      * ,       (
+      * ),    ,    
+      *    .
+      *
+      * @param retry       .
+      *
+      * @return    'ids':    'id', 'rev'
+      *          'id', 'error', 'reason'.   'fnModify'
+      *          -  ;   -
+      *          'not_found'.
+      */
+      CouchFine::Array modifyBulk(
+          const std::vector< uid_t >&  ids,
+          fnModify_t fnModify,
+          size_t retry = 10
+      );
+
+
+
       /**
       *  .
+      *
+      * (!)    .     
+      *   . . warmView().
       */
       void addView(
           const std::string& design,
@@ -184,6 +373,156 @@ class Database {
 
 
 
+      /**
+      *    , [0; 100].
+      */
+      typedef boost::function< void( size_t ) >  fnProgress_t;
+
+
+      /**
+      *     (stale=update_after) 
+      *  ,     /_active_tasks.   
+      *    ,     .
+      *
+      *    /_active_tasks : 
+      *     .
+      *
+      * (!)  : ,   . 
+      *          Communication.
+      *
+      * @param pollInterval    , .
+      *
+      * @return false,       .
+      *            Communication, . DeadlineScope.
+      *
+      * @throw Exception      .
+      */
+      bool warmView(
+          const std::string& viewName,
+          const std::string& designName = "",
+          fnProgress_t fnProgress = fnProgress_t(),
+          size_t pollInterval = 500
+      );
+
+
+      /**
+      *    design-: CouchDB    
+      *  .
+      */
+      bool warmDesign(
+          const std::string& designName = "",
+          fnProgress_t fnProgress = fnProgress_t(),
+          size_t pollInterval = 500
+      );
+
+
+      /**
+      *  design-  .
+      */
+      bool warmDesign(
+          const std::vector< std::string >&  designNames,
+          fnProgress_t fnProgress = fnProgress_t(),
+          size_t pollInterval = 500
+      );
+
+
+
+
+      /**
+      *   .  false -  .
+      */
+      typedef boost::function< bool( const Object& row ) >  fnRow_t;
+
+
+      /**
+      *    _all_docs  , .
+      *     :  
+      *    - .
+      *
+      * @return  ,  'fnRow'.
+      *
+      * @see Scan
+      */
+      size_t scan( const Scan&, fnRow_t fnRow );
+
+
+
+
+
+      /**
+      *   _find (Mango).
+      *
+      * @param query  , . Mode::Find::json().
+      *
+      * @return  : 'docs', 'bookmark' , , 'warning'.
+      */
+      Object find( const std::string& query );
+
+
+      /**
+      *   ,  ,  
+      *  ( 'bookmark').   'fnRow' ,
+      *      .
+      *
+      * @param query 'query.limit' -   
+      *        , 0 - .
+      * @param pageSize    .
+      *
+      * @return  ,  'fnRow'.
+      */
+      size_t find( const Mode::Find& query, fnRow_t fnRow, size_t pageSize = 1000 );
+
+
+      /**
+      *    _find.     , 
+      *  .
+      *
+      * @param indexName  -   .
+      * @param designName  - design-  .
+      *
+      * @return  : 'result' ("created"  "exists"),
+      *         'id', 'name'.
+      */
+      Object createIndex(
+          const std::vector< std::string >&  fields,
+          const std::string& indexName = "",
+          const std::string& designName = ""
+      );
+
+
+      /**
+      * @return   _find,   '_all_docs':
+      *            'ddoc', 'name', 'type', 'def'.
+      */
+      Array indexes();
+
+
+
+
+      /**
+      *    'since' ( _changes):  
+      *   ,    .
+      *
+      * @param since 'last_seq'  . "0" -  ,
+      *        "now" -   .
+      * @param includeDocs     .
+      * @param limit   , 0 -  .
+      * @param longpoll   ,    .
+      *        0 -  . (!)     
+      *        , . Communication::setDeadline().
+      *
+      * @return  : 'results'  'last_seq'.
+      */
+      Object changes(
+          const std::string& since = "0",
+          bool includeDocs = false,
+          size_t limit = 0,
+          size_t longpoll = 0
+      );
+
+
+
+
       inline Communication& getCommunication() {
           return comm;
       }
@@ -193,17 +532,62 @@ class Database {
 
 
    private:
+      /**
+      * @param views  (design-, ).
+      * @see warmView()
+      */
+      bool warm(
+          const std::vector< std::pair< std::string, std::string > >&  views,
+          fnProgress_t fnProgress,
+          size_t pollInterval
+      );
+
+
+      /**
+      * @return    scan(): ,   
+      *           .     
+      *            , . Scan::bounds.
+      *
+      * @param base     _all_docs.
+      */
+      std::vector< std::string >  sampleBounds( const std::string& base, const Scan& );
+
+
+      /**
+      *  -  'd' -  Mode::File::PREFIX().
+      *
+      * @param ora  _bulk_docs  : UID  .
+      */
+      void saveFiles( const Object& d, const Object& ora );
+
+
       Communication&  comm;
       std::string     name;
 
+      /**
+      *   , . trackDigests().
+      */
+      struct Digests;
+      std::shared_ptr< Digests >  digests;
+
+      std::shared_ptr< ViewCache >  viewCache;
+
 
       /**
       *     createBulk( const CouchFine::Object& ).
       */
-      CouchFine::Array      acc;
+      CouchFine::DocPool    acc;
       std::vector< uid_t >  accUID;
       std::string           accPlain;
 
+      /**
+      *    'acc', . coalesce(). 'accIndex' - 
+      *   'acc'  UID.
+      */
+      bool                     accCoalesce;
+      fnMerge_t                accMerge;
+      std::map< uid_t, size_t >  accIndex;
+
 };
 
 }
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "configure.h"
+#include <memory>
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+
+
+namespace CouchFine {
+
+/**
+*        .
+*
+*    : cancel()     ( .. 
+*  )  . ,   . 
+* (Mode::NewUpdate   , Mode::Doc  ..), 
+*    .
+*
+* @see Communication::DeadlineScope
+*/
+class Deadline {
+public:
+    typedef boost::chrono::steady_clock  clock_t;
+
+
+    /**
+    *   .    .
+    */
+    inline Deadline() :
+        limited( false ),
+        cancelFlag( new boost::atomic< bool >( false ) )
+    {
+    }
+
+
+    /**
+    * @param ms     ,    .
+    */
+    inline explicit Deadline( size_t ms ) :
+        at( clock_t::now() + boost::chrono::milliseconds( ms ) ),
+        limited( true ),
+        cancelFlag( new boost::atomic< bool >( false ) )
+    {
+    }
+
+
+    inline bool infinite() const {
+        return !limited;
+    }
+
+
+    /**
+    * @return  , . 0 -  .
+    *            - 'def'.
+    */
+    inline size_t remaining( size_t def = 0 ) const {
+        if ( !limited ) {
+            return def;
+        }
+        const clock_t::time_point now = clock_t::now();
+        return (now < at)
+            ? static_cast< size_t >( boost::chrono::duration_cast< boost::chrono::milliseconds >( at - now ).count() )
+            : 0;
+    }
+
+
+    inline bool expired() const {
+        return limited && (clock_t::now() >= at);
+    }
+
+
+    inline void cancel() {
+        cancelFlag->store( true );
+    }
+
+
+    inline bool cancelled() const {
+        return cancelFlag->load();
+    }
+
+
+    /**
+    * @return true,    .
+    */
+    inline bool over() const {
+        return cancelled() || expired();
+    }
+
+
+
+
+private:
+    clock_t::time_point at;
+    bool limited;
+    std::shared_ptr< boost::atomic< bool > >  cancelFlag;
+};
+
+
+} // namespace CouchFine
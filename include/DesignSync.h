@@ -0,0 +1,104 @@
+#pragma once
+
+#include "configure.h"
+#include "View.h"
+#include "Database.h"
+#include <map>
+
+
+namespace CouchFine {
+
+/**
+* Design-,    :
+*   root/
+*     design1/
+*       view1/ map.js, reduce.js
+*       view2/ map.js
+*     design2/
+*       ...
+*    map.js , design- 
+*  (.git, .svn  ..) - .
+*
+*    ,  (. View::valueOf())
+*   ,  .   design-. 
+*  :   apply() ,   .
+*
+* (!)  design-.  CouchDB    .
+*     design-.
+*
+* :
+*   const DesignSync sync( "design", context );
+*   sync.apply( db );
+*   db.warmDesign( sync.names() );
+*/
+class DesignSync {
+public:
+    /**
+    *  design-,      .
+    */
+    static inline std::string HASH() {
+        return "couchfine_hash";
+    }
+
+
+    struct Design {
+        //   "_design/"
+        std::string name;
+        //   
+        std::vector< View >  views;
+        std::string hash;
+    };
+
+
+    /**
+    * @param threads    .
+    */
+    DesignSync(
+        const std::string& root,
+        const std::map< std::string, std::string >&  context = std::map< std::string, std::string >(),
+        size_t threads = 4
+    );
+
+
+    inline const std::vector< Design >&  designs() const {
+        return designList;
+    }
+
+
+    /**
+    * @return  design- (  "_design/").
+    */
+    std::vector< std::string >  names() const;
+
+
+    /**
+    * @return Design-,     'db', 
+    *               . , 
+    *         'views',   .
+    *           -  .
+    */
+    Array changes( Database& db ) const;
+
+
+    /**
+    *   design-  .
+    *
+    * @return UID  design-.
+    */
+    std::vector< std::string >  apply( Database& db ) const;
+
+
+    /**
+    * @return   .     .
+    */
+    static std::string hashOf( const std::vector< View >&  views );
+
+
+
+
+private:
+    std::vector< Design >  designList;
+};
+
+
+} // CouchFine
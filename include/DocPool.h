@@ -0,0 +1,203 @@
+#pragma once
+
+#include "type.h"
+
+
+namespace CouchFine {
+
+/**
+*  . :   Object,   Variant
+*  ,  Pool.
+*
+*    -  (    )  
+* (  ,    ).  
+*      _id  _rev  .
+*
+*     std::vector:    
+* ,   reserve().     
+*  ,  ,  .
+*
+* :
+*   DocPool pool;
+*   pool.reserve( n );
+*   for (...) {
+*       Object& doc = pool.emplace_back();
+*       doc[ "name" ] = typelib::json::cjv( name );
+*   }
+*   store << Mode::NewUpdate( pool );
+*
+* @see Pool
+* @see Database::createBulk( DocPool& )
+*/
+class DocPool {
+public:
+    inline DocPool() {
+    }
+
+
+    inline explicit DocPool( size_t n ) {
+        entries.reserve( n );
+    }
+
+
+    inline void reserve( size_t n ) {
+        entries.reserve( n );
+    }
+
+
+    inline size_t size() const {
+        return entries.size();
+    }
+
+
+    inline bool empty() const {
+        return entries.empty();
+    }
+
+
+    inline void clear() {
+        entries.clear();
+    }
+
+
+    inline Object& operator[]( size_t i ) {
+        return entries[ i ].doc();
+    }
+
+
+    inline const Object& operator[]( size_t i ) const {
+        return entries[ i ].doc();
+    }
+
+
+    /**
+    * @return  'i' - ,     .
+    */
+    inline bool borrowed( size_t i ) const {
+        return (entries[ i ].ptr != nullptr);
+    }
+
+
+    /**
+    *     .
+    */
+    inline Object& push_back( const Object& doc ) {
+        entries.push_back( Entry() );
+        entries.back().own = doc;
+        return entries.back().own;
+    }
+
+
+    /**
+    *    .   .
+    */
+    inline Object& emplace( Object&& doc ) {
+        entries.push_back( Entry() );
+        entries.back().own = std::move( doc );
+        return entries.back().own;
+    }
+
+
+    /**
+    *     .  -  .
+    */
+    inline Object& emplace_back() {
+        entries.push_back( Entry() );
+        return entries.back().own;
+    }
+
+
+    /**
+    *      .
+    * (!)   ,   .
+    */
+    inline Object& borrow( Object& doc ) {
+        entries.push_back( Entry() );
+        entries.back().ptr = &doc;
+        return doc;
+    }
+
+
+    /**
+    *    :  - ,  - .
+    *     ( ).
+    */
+    inline Object release( size_t i ) {
+        Entry& e = entries[ i ];
+        if ( e.ptr ) {
+            return *e.ptr;
+        }
+        Object r = std::move( e.own );
+        e.own.clear();
+        return r;
+    }
+
+
+    /**
+    *   .  .
+    */
+    inline std::vector< Object >  release() {
+        std::vector< Object >  r;
+        r.reserve( entries.size() );
+        for (size_t i = 0; i < entries.size(); ++i) {
+            r.push_back( release( i ) );
+        }
+        entries.clear();
+        return r;
+    }
+
+
+
+
+private:
+    /**
+    *   -  'own',  -  'ptr'.
+    * # VC10     :   
+    *   std::vector   .
+    */
+    struct Entry {
+        Object own;
+        Object* ptr;
+
+        inline Entry() : ptr( nullptr ) {
+        }
+
+        inline Entry( Entry&& b ) : own( std::move( b.own ) ), ptr( b.ptr ) {
+        }
+
+        inline Entry& operator=( Entry&& b ) {
+            own = std::move( b.own );
+            ptr = b.ptr;
+            return *this;
+        }
+
+        inline Object& doc() {
+            return ptr ? *ptr : own;
+        }
+
+        inline const Object& doc() const {
+            return ptr ? *ptr : own;
+        }
+    };
+
+
+    std::vector< Entry >  entries;
+};
+
+
+
+
+} // CouchFine
+
+
+
+
+// (!)  Object:     _id  _rev.
+// @see DocPool::borrow()
+inline CouchFine::DocPool& operator<<(
+    CouchFine::DocPool& pool,
+    CouchFine::Object* doc
+) {
+    pool.borrow( *doc );
+    return pool;
+}
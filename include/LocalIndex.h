@@ -0,0 +1,279 @@
+#pragma once
+
+#include "configure.h"
+#include "type.h"
+#include "Database.h"
+#include "Deadline.h"
+#include <map>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/unordered_map.hpp>
+
+
+namespace CouchFine {
+
+/**
+*    :  -> ,  
+* 'fnMap'   .   
+*  _all_docs (bootstrap()),     _changes
+* (update()   , . start()).
+*
+*       :  - 
+* ,         .
+*     ,   .  
+*      setPublishInterval() .
+*
+*    .    . ,
+*      UID -   
+* .     ,   
+*   .
+*
+* :
+*   LocalIndex byEmail( store, [] ( const Object& doc, const LocalIndex::fnEmit_t& emit ) {
+*       if (v< std::string >( doc, "type" ) == "user") {
+*           emit( v< std::string >( doc, "email" ), typelib::json::cjv( uid( doc ) ) );
+*       }
+*   } );
+*   byEmail.bootstrap();
+*   byEmail.start();
+*   ...
+*   const Variant id = byEmail.get( "a@b.c" );
+*
+* (!)  start() 'store'     Communication:
+*     Communication  .
+* (!)   :     .
+*/
+class LocalIndex {
+public:
+    enum Kind {
+        // boost::unordered_map
+        HASH,
+        // std::map:    , . range()
+        ORDERED
+    };
+
+
+    /**
+    *      .
+    */
+    typedef boost::function< void( const std::string& key, const Variant& value ) >  fnEmit_t;
+
+    /**
+    *   . ,   , 
+    *  .    'fnMap'  .
+    */
+    typedef boost::function< void( const Object& doc, const fnEmit_t& emit ) >  fnMap_t;
+
+    /**
+    *    .  false -  .
+    */
+    typedef boost::function< bool( const std::string& key, const Variant& value ) >  fnEntry_t;
+
+
+    /**
+    * @param design, view   bootstrap().  'view' -
+    *        _all_docs.    : 
+    *         _changes 'fnMap'  .
+    */
+    LocalIndex(
+        Database& store,
+        fnMap_t fnMap,
+        Kind kind = HASH,
+        const std::string& design = "",
+        const std::string& view = ""
+    );
+
+
+    virtual ~LocalIndex();
+
+
+    /**
+    *      (_all_docs).  
+    *   : ,   
+    * ,   update().
+    *
+    * @return -  .
+    */
+    size_t bootstrap();
+
+
+    /**
+    *      _changes  seq().
+    *
+    *      ('limit'),  
+    *     setPublishInterval() ;   - .
+    *       setPublishInterval();
+    * bootstrap()  .      
+    *    ,  .
+    *
+    * @param longpoll   ,    . 0 -  .
+    * @param limit    .
+    *
+    * @return -  .
+    */
+    size_t update( size_t longpoll = 0, size_t limit = 1000 );
+
+
+    /**
+    * @param ms    ,  update() 
+    *        . 0 -   .
+    */
+    void setPublishInterval( size_t ms );
+
+
+    /**
+    *  ,  update()  'longpoll'. 
+    *   : . lastError();   - 
+    * 'pause' .
+    *
+    * @param longpoll    Communication (10 ).
+    */
+    void start( size_t longpoll = 5000, size_t pause = 1000 );
+
+
+    /**
+    *  .    _changes :
+    * curl      .
+    */
+    void stop();
+
+
+    bool running() const;
+
+
+    /**
+    * @return   update()  ,  -  .
+    */
+    std::string lastError() const;
+
+
+
+
+    /**
+    * @return false,     .
+    */
+    bool get( const std::string& key, Variant& value ) const;
+
+
+    /**
+    * @return  ,  Variant -  .
+    */
+    Variant get( const std::string& key ) const;
+
+
+    bool has( const std::string& key ) const;
+
+
+    size_t size() const;
+
+
+    /**
+    *    [from; to]  .  'to' -
+    *   .   ORDERED.
+    *
+    * @return - ,  'fnEntry'.
+    */
+    size_t range( const std::string& from, const std::string& to, fnEntry_t fnEntry ) const;
+
+
+    /**
+    * @return    , . Database::changes().
+    */
+    std::string seq() const;
+
+
+
+
+private:
+    struct Entry {
+        Variant value;
+        // ,  
+        uid_t id;
+    };
+
+    /**
+    *     .
+    *     -  'kind'.
+    */
+    struct Snapshot {
+        boost::unordered_map< std::string, Entry >  hash;
+        std::map< std::string, Entry >  ordered;
+        std::string seq;
+    };
+
+    typedef boost::shared_ptr< const Snapshot >  snapshot_ptr;
+
+
+    /**
+    *   's'   'id'   
+    * 'fnMap'  'doc'.  'doc' -  .
+    *   'writing'.
+    */
+    void reindex( Snapshot& s, const uid_t& id, const Object* doc );
+    void put( Snapshot& s, const uid_t& id, const std::string& key, const Variant& value );
+
+
+    /**
+    *    's'.  'id' -  .
+    */
+    Entry* find( Snapshot& s, const std::string& key ) const;
+    void assign( Snapshot& s, const std::string& key, const uid_t& id, const Variant& value ) const;
+
+
+    void run( size_t longpoll, size_t pause, Deadline deadline );
+
+
+    /**
+    *   'working'.   'writing'.
+    */
+    void publish();
+
+
+    snapshot_ptr load() const;
+
+
+
+
+private:
+    Database& store;
+    const fnMap_t fnMap;
+    const Kind kind;
+    const std::string design;
+    const std::string view;
+
+    //   : boost::atomic_load()
+    snapshot_ptr current;
+
+    //  ->    ( ).   'writing'.
+    std::map< uid_t, std::vector< std::string > >  docKeys;
+    // ,  . :  -> . 
+    //    .   'writing'.
+    std::map< std::string, std::map< uid_t, Variant > >  shared;
+    // ,    .  -   'current'.
+    boost::shared_ptr< Snapshot >  working;
+    Deadline::clock_t::time_point  published;
+    size_t publishInterval;
+    //    bootstrap(): update() ,   
+    size_t generation;
+    boost::mutex  writing;
+
+    //   'store': Communication  . 
+    //  'writing'.
+    boost::mutex  requesting;
+    //    update():    long-poll
+    Deadline  polling;
+    boost::atomic< size_t >  bootstrapping;
+
+    boost::thread  thread;
+    Deadline  cancel;
+    boost::atomic< bool >  stopping;
+    std::string error;
+    mutable boost::mutex  errorMutex;
+};
+
+
+} // CouchFine
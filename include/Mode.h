@@ -3,8 +3,13 @@
 #include "configure.h"
 #include "type.h"
 #include "Pool.h"
+#include "DocPool.h"
+#include "Deadline.h"
 #include "Exception.h"
+#include "Selector.h"
+#include "SeenFilter.h"
 #include <vector>
+#include <boost/optional.hpp>
 
 
 namespace CouchFine {
@@ -21,19 +26,32 @@ private:
     *      .
     *
     * @see Pool
+    * @see DocPool
     */
     struct Save {
         Object* const o;
         Pool* const p;
+        DocPool* const dp;
         const fnCreateJSON_t fnCreateJSON;
 
+        //     ,   .
+        //   -  ,   Communication.
+        // @see Communication::DeadlineScope
+        boost::optional< Deadline >  deadline;
+
         inline Save( Object& o, fnCreateJSON_t fnCreateJSON ) :
-            o( &o ), p( nullptr ), fnCreateJSON( fnCreateJSON )
+            o( &o ), p( nullptr ), dp( nullptr ), fnCreateJSON( fnCreateJSON )
         {
         };
 
         inline Save( Pool& p, fnCreateJSON_t fnCreateJSON ) :
-            o( nullptr ), p( &p ), fnCreateJSON( fnCreateJSON )
+            o( nullptr ), p( &p ), dp( nullptr ), fnCreateJSON( fnCreateJSON )
+        {
+        };
+
+        //   NewOnly, NewSkip, NewUpdate
+        inline Save( DocPool& dp, fnCreateJSON_t fnCreateJSON ) :
+            o( nullptr ), p( nullptr ), dp( &dp ), fnCreateJSON( fnCreateJSON )
         {
         };
 
@@ -99,6 +117,11 @@ private:
         //     -   .
         const size_t limit;
 
+        //     .
+        //   -  ,   Communication.
+        // @see Communication::DeadlineScope
+        boost::optional< Deadline >  deadline;
+
         // 
         // (!)    limit / offset,  'totalRows'
         //    'result.count()'; 'totalRows' -  -, ,
@@ -155,6 +178,7 @@ public:
     struct NewOnly : public Save {
         inline NewOnly( Object& o, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( o, fnCreateJSON ) {};
         inline NewOnly( Pool& p, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( p, fnCreateJSON ) {};
+        inline NewOnly( DocPool& dp, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( dp, fnCreateJSON ) {};
     };
 
     /**
@@ -165,17 +189,30 @@ public:
     struct NewSkip : public Save {
         inline NewSkip( Object& o, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( o, fnCreateJSON ) {};
         inline NewSkip( Pool& p, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( p, fnCreateJSON ) {};
+        inline NewSkip( DocPool& dp, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( dp, fnCreateJSON ) {};
     };
 
-    /** - @todo     UID,   .
+    /**
     *  ,  NewSkip,   ,   
     *     - .
     *
+    *   'seen'    UID,  
+    * . UID,  'seen', ,  ,  
+    *   _all_docs:      .
+    *
+    * @see SeenFilter::seed()
+    */
     struct NewSkipMany : public Save {
-        inline NewSkipMany( const Object& o ) : Save( o ) {};
-        inline NewSkipMany( const Pool&   p ) : Save( p ) {};
+        SeenFilter& seen;
+
+        //     UID,  'seen', , .
+        // false -     ;  
+        //   ( - . SeenFilter())  .
+        bool verify;
+
+        inline NewSkipMany( Object& o, SeenFilter& seen, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( o, fnCreateJSON ), seen( seen ), verify( true ) {};
+        inline NewSkipMany( Pool& p, SeenFilter& seen, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( p, fnCreateJSON ), seen( seen ), verify( true ) {};
     };
-    */
 
     /**
     *      .
@@ -185,8 +222,14 @@ public:
     *   .
     */
     struct NewUpdate : public Save {
+        // UID ,   :   
+        //   .   .
+        // @see Database::trackDigests()
+        std::vector< uid_t >  skipped;
+
         inline NewUpdate( Object& o, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( o, fnCreateJSON ) {};
         inline NewUpdate( Pool& p, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( p, fnCreateJSON ) {};
+        inline NewUpdate( DocPool& dp, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( dp, fnCreateJSON ) {};
     };
 
 
@@ -199,13 +242,39 @@ public:
     *         .
     */
     struct View : public Load {
+        /**
+        *   .
+        *
+        * CouchDB 2.x     'stale',   
+        * update=false (STALE_OK) / update=lazy (UPDATE_AFTER). 
+        * 'stale':    .
+        *
+        * @see Database::warmView()
+        */
+        enum Freshness {
+            //    
+            FRESH,
+            //    ,   : stale=ok
+            STALE_OK,
+            //        
+            // : stale=update_after
+            UPDATE_AFTER
+        };
+
+        const Freshness freshness;
+
+
         inline View(
             const std::string& design,
             const std::string& view,
             const std::string& key,
             bool withDoc,
-            size_t limit = 0
-        ) : Load( design, view, key, withDoc, limit ) {
+            size_t limit = 0,
+            Freshness freshness = FRESH
+        ) :
+            Load( design, view, key, withDoc, limit ),
+            freshness( freshness )
+        {
             assert ( !view.empty() && "    ." );
         };
     };
@@ -239,17 +308,127 @@ public:
 
 
 
-#if 0
-// - @todo ...
+    /**
+    *   _find (Mango):     
+    *        'fields'.
+    *
+    *  operator>>()      'bookmark':
+    *  operator>>()       .
+    *    - . Database::find().
+    *
+    * @see Selector
+    * @see Database::createIndex()
+    */
+    struct Find {
+        Selector selector;
+
+        //   .  -  .
+        // (!)  '_id'      UID.
+        std::vector< std::string >  fields;
+
+        // : (,  ).    
+        //    .
+        std::vector< std::pair< std::string, bool > >  sort;
+
+        //   . 0 -    (25).
+        //  Database::find( query, fnRow ) -  , 0 - .
+        size_t limit;
+        size_t skip;
+
+        // Design- ,   
+        std::string useIndex;
+
+        //  .    .
+        std::string bookmark;
+
+        //     .
+        //   -  ,   Communication.
+        // @see Communication::DeadlineScope
+        boost::optional< Deadline >  deadline;
+
+        // :  ( ,   )
+        Array result;
+        //  ,  "no matching index found"
+        std::string warning;
+        bool ok;
+        std::shared_ptr< Exception >  exception;
+
+
+        inline Find(
+            const Selector& selector = Selector(),
+            size_t limit = 0
+        ) :
+            selector( selector ),
+            limit( limit ),
+            skip( 0 ),
+            ok( false ), exception( nullptr )
+        {
+        };
+
+
+        /**
+        * @return    _find.
+        *
+        * @param pageLimit  'limit',   0.
+        */
+        inline std::string json( size_t pageLimit = 0 ) const {
+            Object o;
+            o[ "selector" ] = typelib::json::cjv( selector.object() );
+            if ( !fields.empty() ) {
+                Array a;
+                for (auto itr = fields.cbegin(); itr != fields.cend(); ++itr) {
+                    a.push_back( typelib::json::cjv( *itr ) );
+                }
+                o[ "fields" ] = typelib::json::cjv( a );
+            }
+            if ( !sort.empty() ) {
+                Array a;
+                for (auto itr = sort.cbegin(); itr != sort.cend(); ++itr) {
+                    Object order;
+                    order[ itr->first ] = typelib::json::cjv( std::string( itr->second ? "desc" : "asc" ) );
+                    a.push_back( typelib::json::cjv( order ) );
+                }
+                o[ "sort" ] = typelib::json::cjv( a );
+            }
+            const size_t n = (pageLimit > 0) ? pageLimit : limit;
+            if (n > 0) {
+                o[ "limit" ] = typelib::json::cjv( static_cast< int >( n ) );
+            }
+            if (skip > 0) {
+                o[ "skip" ] = typelib::json::cjv( static_cast< int >( skip ) );
+            }
+            if ( !useIndex.empty() ) {
+                o[ "use_index" ] = typelib::json::cjv( useIndex );
+            }
+            if ( !bookmark.empty() ) {
+                o[ "bookmark" ] = typelib::json::cjv( bookmark );
+            }
+            std::ostringstream ss;
+            ss << typelib::json::cjv( o );
+            return ss.str();
+        }
+    };
+
+
+
+
     /**
     *  "-"    .
     *   ,    * *.
     *      (  UID),   ..
     *  UID .  ,   ..
+    *
+    *   :  _update design-
+    *  (   ).   
+    * ,   .     . 
+    *     .   , 
+    *  .
+    *
+    *  Pool   .
     */
-    struct AppendNewOnly {
-        const CouchFine::Object& o;
-        inline AppendNewOnly( const CouchFine::Object& o ) : o( o ) {};
+    struct AppendNewOnly : public Save {
+        inline AppendNewOnly( Object& o, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( o, fnCreateJSON ) {};
+        inline AppendNewOnly( Pool& p, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( p, fnCreateJSON ) {};
     };
 
     /**
@@ -257,15 +436,14 @@ public:
     *   ,    **.
     *      (  UID),   ..
     *  UID .  ,   ..
+    *
+    * @see AppendNewOnly
     */
-    struct AppendUpdate {
-        const CouchFine::Object& o;
-        inline AppendUpdate( const CouchFine::Object& o ) : o( o ) {};
+    struct AppendUpdate : public Save {
+        inline AppendUpdate( Object& o, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( o, fnCreateJSON ) {};
+        inline AppendUpdate( Pool& p, fnCreateJSON_t fnCreateJSON = fnCreateJSON_t() ) : Save( p, fnCreateJSON ) {};
     };
 
-    // @todo ...
-#endif
-
 
 
 
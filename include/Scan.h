@@ -0,0 +1,68 @@
+#pragma once
+
+#include "configure.h"
+
+
+namespace CouchFine {
+
+/**
+*    _all_docs  .
+*
+*     ,   
+* (   , . Communication::getDataBatch()),  -
+*   'pageSize' .
+*
+* @see Database::scan()
+*/
+struct Scan {
+    // Design-  .  'view' -  _all_docs.
+    std::string design;
+    std::string view;
+
+    //   -    JSON,  "\"a\"" 
+    // "[2012,1]".   -  . 'endkey'   .
+    std::string startkey;
+    std::string endkey;
+
+    //     
+    bool withDoc;
+
+    //     
+    size_t partitions;
+
+    //   -    JSON,  .  
+    //   .  -    
+    //   (.  ,  'skip').  ,
+    //     ;      - : 
+    //     .
+    std::vector< std::string >  bounds;
+
+    //      CouchDB.  -  
+    // ,    .
+    bool ordered;
+
+    //    
+    size_t pageSize;
+
+    //  'ordered':      
+    //  ,   
+    size_t lookahead;
+
+
+    inline Scan(
+        const std::string& design = "",
+        const std::string& view = ""
+    ) :
+        design( design ),
+        view( view ),
+        withDoc( false ),
+        partitions( 8 ),
+        ordered( false ),
+        pageSize( 1000 ),
+        lookahead( 4 )
+    {
+    }
+};
+
+
+} // CouchFine
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "configure.h"
+#include "type.h"
+#include <boost/cstdint.hpp>
+
+
+namespace CouchFine {
+
+class Database;
+
+
+/**
+*  UID,    :  .
+*   UID     1% -  1.2 .
+*
+*  " "  ", ". "" 
+*  , . Mode::NewSkipMany.
+*
+* (!)  .
+*/
+class SeenFilter {
+public:
+    /**
+    * @param expected  - UID.    
+    *         .
+    * @param falsePositive    , (0; 1).
+    */
+    explicit SeenFilter( size_t expected = 1000000, double falsePositive = 0.01 );
+
+
+    void add( const uid_t& );
+
+
+    /**
+    * @return false - UID   . true - , .
+    */
+    bool mayContain( const uid_t& ) const;
+
+
+    /**
+    * @return   (  ).
+    */
+    inline size_t count() const {
+        return n;
+    }
+
+
+    /**
+    * @return  , .
+    */
+    inline size_t bytes() const {
+        return bits.size() * sizeof( boost::uint64_t );
+    }
+
+
+    void clear();
+
+
+    /**
+    *  UID    ( design-.):
+    *  _all_docs  , . Database::scan().
+    *
+    * @return   UID.
+    */
+    size_t seed( Database&, size_t partitions = 8 );
+
+
+    /**
+    *     /   .  
+    *     .
+    */
+    void save( const std::string& file ) const;
+    static SeenFilter load( const std::string& file );
+
+
+
+
+private:
+    /**
+    *   : h1 + i * h2 ( ).
+    */
+    void hash( const uid_t&, boost::uint64_t& h1, boost::uint64_t& h2 ) const;
+
+
+    std::vector< boost::uint64_t >  bits;
+    boost::uint64_t nbits;
+    size_t k;
+    size_t n;
+};
+
+
+} // CouchFine
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "configure.h"
+#include "type.h"
+// operator<<( std::ostream&, const Variant& ) -   JSON
+#include "Communication.h"
+
+
+namespace CouchFine {
+
+/**
+*      _find (Mango, CouchDB 2.x  ).
+*
+*       "".    
+*    : gt( "n", a ).lt( "n", b ) ->
+* {"n": {"$gt": a, "$lt": b}}.   -  : "a.b".
+*
+* :
+*   Selector s;
+*   s.eq( "type", typelib::json::cjv( std::string( "order" ) ) )
+*    .gte( "total", typelib::json::cjv( 1000 ) );
+*
+* @see Mode::Find
+* @see http://docs.couchdb.org/en/latest/api/database/find.html#selector-syntax
+*/
+class Selector {
+public:
+    inline Selector() {
+    }
+
+
+    inline Selector& eq(  const std::string& field, const Variant& v ) { return op( field, "$eq",  v ); }
+    inline Selector& ne(  const std::string& field, const Variant& v ) { return op( field, "$ne",  v ); }
+    inline Selector& gt(  const std::string& field, const Variant& v ) { return op( field, "$gt",  v ); }
+    inline Selector& gte( const std::string& field, const Variant& v ) { return op( field, "$gte", v ); }
+    inline Selector& lt(  const std::string& field, const Variant& v ) { return op( field, "$lt",  v ); }
+    inline Selector& lte( const std::string& field, const Variant& v ) { return op( field, "$lte", v ); }
+
+
+    /**
+    *   -   'values'.
+    */
+    inline Selector& in( const std::string& field, const Array& values ) {
+        return op( field, "$in", typelib::json::cjv( values ) );
+    }
+
+    inline Selector& nin( const std::string& field, const Array& values ) {
+        return op( field, "$nin", typelib::json::cjv( values ) );
+    }
+
+
+    inline Selector& exists( const std::string& field, bool present = true ) {
+        return op( field, "$exists", typelib::json::cjv( present ) );
+    }
+
+
+    /**
+    *     Erlang (PCRE).
+    */
+    inline Selector& regex( const std::string& field, const std::string& pattern ) {
+        return op( field, "$regex", typelib::json::cjv( pattern ) );
+    }
+
+
+    /**
+    *      : $or.
+    *     .
+    */
+    inline Selector& anyOf( const std::vector< Selector >&  alternatives ) {
+        return combine( "$or", alternatives );
+    }
+
+    /**
+    *      : $nor.
+    */
+    inline Selector& noneOf( const std::vector< Selector >&  alternatives ) {
+        return combine( "$nor", alternatives );
+    }
+
+
+    inline bool empty() const {
+        return o.empty();
+    }
+
+
+    inline const Object& object() const {
+        return o;
+    }
+
+
+    /**
+    * @return    JSON.     .
+    */
+    inline std::string json() const {
+        std::ostringstream ss;
+        ss << typelib::json::cjv( o );
+        return ss.str();
+    }
+
+
+
+
+private:
+    inline Selector& op( const std::string& field, const std::string& name, const Variant& v ) {
+        Object condition;
+        const auto ftr = o.find( field );
+        if ( (ftr != o.cend()) && ftr->second && (ftr->second->type() == typeid( Object )) ) {
+            condition = boost::any_cast< Object >( *ftr->second );
+        }
+        condition[ name ] = v;
+        o[ field ] = typelib::json::cjv( condition );
+        return *this;
+    }
+
+
+    inline Selector& combine( const std::string& name, const std::vector< Selector >&  alternatives ) {
+        Array a;
+        for (auto itr = alternatives.cbegin(); itr != alternatives.cend(); ++itr) {
+            a.push_back( typelib::json::cjv( itr->o ) );
+        }
+        Object c;
+        c[ name ] = typelib::json::cjv( a );
+
+        //  $or     :   $and
+        Array all;
+        const auto ftr = o.find( "$and" );
+        if (ftr != o.cend()) {
+            all = boost::any_cast< Array >( *ftr->second );
+        }
+        all.push_back( typelib::json::cjv( c ) );
+        o[ "$and" ] = typelib::json::cjv( all );
+        return *this;
+    }
+
+
+    Object o;
+};
+
+
+} // CouchFine
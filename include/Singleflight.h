@@ -0,0 +1,113 @@
+#pragma once
+
+#include "configure.h"
+#include "type.h"
+#include "Communication.h"
+#include <map>
+#include <memory>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+
+namespace CouchFine {
+
+/**
+*    :    
+* ( + URL) ,       
+*       .
+*
+*     Communication (   ),
+* . Communication::setSingleflight().   GET  HEAD
+*      .
+*
+*      :   .
+*       (Deadline);  
+*      ,  
+*  .
+*/
+class Singleflight {
+public:
+    /**
+    *  :  ,   .
+    */
+    struct Response {
+        Variant data;
+        long status;
+        Communication::HeaderMap headers;
+
+        inline Response() : status( 0 ) {
+        }
+    };
+
+    typedef boost::function< Response() >  fnFetch_t;
+
+
+    Singleflight();
+
+
+    /**
+    * @return      'key'.      -
+    *          ,  -  'fetch'.
+    *          'fetch'    Exception.
+    *
+    * @param deadline       .
+    */
+    Response run( const std::string& key, fnFetch_t fetch, const Deadline& deadline = Deadline() );
+
+
+    /**
+    * .
+    */
+    struct Stats {
+        //  
+        size_t flights;
+        // ,   
+        size_t collapsed;
+
+        inline Stats() : flights( 0 ), collapsed( 0 ) {
+        }
+    };
+
+    Stats stats() const;
+
+
+
+
+private:
+    struct Flight {
+        bool done;
+        Response response;
+        std::string error;
+        //  -       
+        bool expired;
+        //    
+        size_t waiters;
+
+        inline Flight() : done( false ), expired( false ), waiters( 0 ) {
+        }
+    };
+
+
+    /**
+    *   ( ) .
+    *
+    * @return    .
+    */
+    size_t land(
+        const std::string&               key,
+        const std::shared_ptr< Flight >&  flight,
+        const std::string&               error,
+        bool                             expired
+    );
+
+
+    std::map< std::string, std::shared_ptr< Flight > >  flights;
+    Stats counters;
+
+    mutable boost::mutex  mutex;
+    boost::condition_variable  landed;
+};
+
+
+} // CouchFine
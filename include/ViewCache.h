@@ -0,0 +1,141 @@
+#pragma once
+
+#include "configure.h"
+#include "type.h"
+#include "Deadline.h"
+#include <list>
+#include <map>
+#include <memory>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+
+namespace CouchFine {
+
+/**
+*    .
+*
+*      :  
+*  If-None-Match,    304  , 
+*    .  
+*      .
+*
+* :      Database,  
+*     Communication (   ).
+*
+* :
+*   auto cache = std::make_shared< ViewCache >( 500 );
+*   db.setViewCache( cache );
+*   db >> Mode::View( "d", "v", "key=1", true );
+*
+* @see Database::setViewCache()
+*/
+class ViewCache {
+public:
+    /**
+    *    .
+    *
+    * @param etag ETag   .  -  .
+    * @param newETag ETag  .
+    * @param result  .
+    * @return false -    (304), 'result'  .
+    */
+    typedef boost::function< bool(
+        const std::string& etag,
+        std::string& newETag,
+        Object& result
+    ) >  fnFetch_t;
+
+
+    /**
+    * @param capacity   .   
+    *         .
+    */
+    explicit ViewCache( size_t capacity = 1000 );
+
+
+    /**
+    * @return    'key':  ,    304,
+    *          -  'fetch' (   ).
+    *
+    * @param deadline        .
+    *                 ,
+    *         .
+    *
+    *  -  (deepCopy()):   ,   .
+    */
+    Object get( const std::string& key, fnFetch_t fetch, const Deadline& deadline = Deadline() );
+
+
+    void clear();
+
+
+    size_t size() const;
+
+
+    /**
+    *  .
+    */
+    struct Stats {
+        //   304:    
+        size_t revalidated;
+        //     
+        size_t fetched;
+        //   ,   
+        size_t collapsed;
+        //  
+        size_t evicted;
+
+        inline Stats() : revalidated( 0 ), fetched( 0 ), collapsed( 0 ), evicted( 0 ) {
+        }
+    };
+
+    Stats stats() const;
+
+
+    /**
+    * @return    ,   :
+    *         "limit=5&key=1"  "key=1&limit=5"    .
+    */
+    static std::string normalizeQuery( const std::string& query );
+
+
+
+
+private:
+    struct Entry {
+        std::string etag;
+        std::shared_ptr< const Object >  result;
+        std::list< std::string >::iterator  lru;
+    };
+
+    /**
+    * ,        .
+    */
+    struct Flight {
+        bool done;
+        std::shared_ptr< const Object >  result;
+        std::string error;
+        //  -      
+        bool expired;
+
+        inline Flight() : done( false ), expired( false ) {
+        }
+    };
+
+
+    const size_t capacity;
+
+    std::map< std::string, Entry >  entries;
+    // :   -  
+    std::list< std::string >  lru;
+    std::map< std::string, std::shared_ptr< Flight > >  flights;
+    Stats counters;
+
+    mutable boost::mutex  mutex;
+    boost::condition_variable  landed;
+};
+
+
+} // CouchFine
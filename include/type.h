@@ -199,8 +199,9 @@ static inline bool hasRevision( const Object& o ) {
 
 
 /**
-* @return      ,   .
-*                 .
+* @return    ("error: reason")   , 
+*          .       
+*          .
 */
 static inline std::string error( const Object& o ) {
     const auto fte = o.find( "error" );
@@ -208,8 +209,9 @@ static inline std::string error( const Object& o ) {
         std::string e = boost::any_cast< std::string >( *fte->second );
         const auto ftr = o.find( "reason" );
         if (ftr != o.cend()) {
-            e += boost::any_cast< std::string >( *ftr->second );
+            e += ": " + boost::any_cast< std::string >( *ftr->second );
         }
+        return e;
     }
     return "";
 }
@@ -264,6 +266,42 @@ static inline bool ok( const Object& o ) {
 
 
 
+
+/**
+* @return ,      Object  Array.
+*         ,       
+*          (,  ):   .
+*/
+static inline Variant deepCopy( const Variant& var );
+
+static inline Object deepCopy( const Object& o ) {
+    Object r;
+    for (auto itr = o.cbegin(); itr != o.cend(); ++itr) {
+        r[ itr->first ] = deepCopy( itr->second );
+    }
+    return r;
+}
+
+static inline Variant deepCopy( const Variant& var ) {
+    if ( !var ) {
+        return var;
+    }
+    if (var->type() == typeid( Object )) {
+        return typelib::json::cjv( deepCopy( boost::any_cast< const Object& >( *var ) ) );
+    }
+    if (var->type() == typeid( Array )) {
+        const Array& a = boost::any_cast< const Array& >( *var );
+        Array r;
+        for (auto itr = a.cbegin(); itr != a.cend(); ++itr) {
+            r.push_back( deepCopy( *itr ) );
+        }
+        return typelib::json::cjv( r );
+    }
+    return typelib::json::cjv( *var );
+}
+
+
+
 } // CouchFine
 
 
@@ -1,10 +1,20 @@
 #include "../include/Communication.h"
+#include "../include/Singleflight.h"
+#include <cstring>
 #include <boost/assign.hpp>
+#include <boost/chrono.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/thread.hpp>
+#include <zlib.h>
 
 using namespace CouchFine;
 
 const std::string DEFAULT_COUCHDB_URL = "http://localhost:5984";
 
+// (!)    CouchDB    
+// . . :   :)
+const long DEFAULT_TIMEOUT = 10000;
+
 
 // @source http://blooberry.com/indexdot/html/topics/urlencoding.htm
 // (!)  :  '%'     .
@@ -52,7 +62,7 @@ const std::map< std::string, std::string >  Communication::FROM_RFC1738_SLASH =
 
 
 
-static Variant parseData( const std::string& buffer ) {
+Variant Communication::parseData( const std::string& buffer ) {
    
    /* -     typelib. . .
    const auto t = json::parse( buffer.begin(), buffer.end() );
@@ -89,6 +99,91 @@ static Variant parseData( const std::string& buffer ) {
 
 
 
+/**
+*       curl: DNS,  TLS, .
+*  Communication        
+* ,     .
+*
+* (!)        :  
+*      Communication.
+*/
+namespace {
+
+CURLSH* share = nullptr;
+
+boost::mutex shareLocks[ CURL_LOCK_DATA_LAST ];
+
+boost::once_flag shareOnce = BOOST_ONCE_INIT;
+
+
+
+
+void lockShare( CURL*, curl_lock_data data, curl_lock_access, void* ) {
+    shareLocks[ data ].lock();
+}
+
+
+
+
+void unlockShare( CURL*, curl_lock_data data, void* ) {
+    shareLocks[ data ].unlock();
+}
+
+
+
+
+void initShare() {
+    // (!) curl_global_init()  
+    curl_global_init( CURL_GLOBAL_DEFAULT );
+
+    share = curl_share_init();
+    if ( !share ) {
+        return;
+    }
+    curl_share_setopt( share, CURLSHOPT_LOCKFUNC, lockShare );
+    curl_share_setopt( share, CURLSHOPT_UNLOCKFUNC, unlockShare );
+    curl_share_setopt( share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS );
+    curl_share_setopt( share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION );
+#if LIBCURL_VERSION_NUM >= 0x073900
+    //      curl 7.57.0
+    curl_share_setopt( share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT );
+#endif
+}
+
+} // namespace
+
+
+
+
+/**
+*     'm',    'timeout' .
+*/
+static void waitMulti( CURLM* m, int timeout ) {
+#if LIBCURL_VERSION_NUM >= 0x071C00
+    curl_multi_wait( m, nullptr, 0, timeout, nullptr );
+#else
+    // curl_multi_wait()   curl 7.28.0
+    fd_set r, w, e;
+    FD_ZERO( &r );
+    FD_ZERO( &w );
+    FD_ZERO( &e );
+    int maxfd = -1;
+    curl_multi_fdset( m, &r, &w, &e, &maxfd );
+    if (maxfd == -1) {
+        // curl    :  
+        boost::this_thread::sleep_for( boost::chrono::milliseconds( std::min( timeout, 10 ) ) );
+        return;
+    }
+    timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    select( maxfd + 1, &r, &w, &e, &tv );
+#endif
+}
+
+
+
+
 static int writer( char *data, size_t size, size_t nmemb, std::string* dest ) {
     int written = 0;
     if ( dest ) {
@@ -102,6 +197,111 @@ static int writer( char *data, size_t size, size_t nmemb, std::string* dest ) {
 
 
 
+/**
+*   .   ("HTTP/1.1 200 OK")
+*   :   (100 Continue,
+* ) .
+*/
+static size_t headerWriter( char* data, size_t size, size_t nmemb, Communication::HeaderMap* dest ) {
+    const size_t n = size * nmemb;
+    if ( !dest ) {
+        return n;
+    }
+    const std::string line( data, n );
+    if ( boost::starts_with( line, "HTTP/" ) ) {
+        dest->clear();
+        return n;
+    }
+    const size_t colon = line.find( ':' );
+    if (colon != std::string::npos) {
+        const std::string name = boost::to_lower_copy( line.substr( 0, colon ) );
+        ( *dest )[ name ] = boost::trim_copy( line.substr( colon + 1 ) );
+    }
+    return n;
+}
+
+
+
+
+/**
+*  ,   .  curl  
+*   ,       1 .
+*     curl  CURLOPT_TIMEOUT_MS.
+*/
+#if LIBCURL_VERSION_NUM >= 0x072000
+static int progress( void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t ) {
+#else
+// CURLOPT_XFERINFOFUNCTION   curl 7.32.0
+static int progress( void* clientp, double, double, double, double ) {
+#endif
+    const Deadline* deadline = static_cast< const Deadline* >( clientp );
+    return deadline->cancelled() ? 1 : 0;
+}
+
+
+
+
+/**
+*      gzip    .
+*
+* @see Communication::setRequestCompression()
+*/
+struct GzipReader {
+    z_stream z;
+    const std::string* source;
+    size_t pos;
+    bool finished;
+
+    inline GzipReader( const std::string* source, int level ) :
+        source( source ), pos( 0 ), finished( false )
+    {
+        std::memset( &z, 0, sizeof( z ) );
+        // 16 + MAX_WBITS -  gzip,   zlib
+        if (deflateInit2( &z, level, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
+           throw Exception( "Unable to initialize gzip stream" );
+    }
+
+    inline ~GzipReader() {
+        deflateEnd( &z );
+    }
+
+private:
+    GzipReader( const GzipReader& );
+    GzipReader& operator=( const GzipReader& );
+};
+
+
+
+
+static size_t gzipReader( void* ptr, size_t size, size_t nmemb, GzipReader* g ) {
+    if ( g->finished ) {
+        return 0;
+    }
+    const size_t capacity = size * nmemb;
+    g->z.next_out = static_cast< Bytef* >( ptr );
+    g->z.avail_out = static_cast< uInt >( capacity );
+    while ( (g->z.avail_out > 0) && !g->finished ) {
+        // zlib    uInt  
+        const size_t left = g->source->size() - g->pos;
+        const size_t portion = std::min< size_t >( left, 1 << 20 );
+        g->z.next_in = reinterpret_cast< Bytef* >( const_cast< char* >( g->source->data() ) + g->pos );
+        g->z.avail_in = static_cast< uInt >( portion );
+        const int r = deflate( &g->z, (portion == left) ? Z_FINISH : Z_NO_FLUSH );
+        g->pos += portion - g->z.avail_in;
+        if (r == Z_STREAM_END) {
+            g->finished = true;
+        } else if (r == Z_BUF_ERROR) {
+            break;
+        } else if (r != Z_OK) {
+            return CURL_READFUNC_ABORT;
+        }
+    }
+    return capacity - g->z.avail_out;
+}
+
+
+
+
 static size_t reader( void* ptr, size_t size, size_t nmemb, std::string* stream ) {
     int actual  = (int)stream->size();
     int written = size * nmemb;
@@ -115,6 +315,47 @@ static size_t reader( void* ptr, size_t size, size_t nmemb, std::string* stream
 
 
 
+/**
+*     'body'  'h'.  'compress'
+*    , . Communication::setRequestCompression().
+*  Content-Encoding  .
+*
+* @return  :     .
+*          -   .
+*/
+static std::shared_ptr< GzipReader >  setBody( CURL* h, std::string& body, bool compress, int level ) {
+   std::shared_ptr< GzipReader >  gzip;
+   if ( compress ) {
+      gzip.reset( new GzipReader( &body, level ) );
+
+      if (curl_easy_setopt( h, CURLOPT_READFUNCTION, gzipReader ) != CURLE_OK)
+         throw Exception( "Unable to set read function" );
+
+      if (curl_easy_setopt( h, CURLOPT_READDATA, gzip.get() ) != CURLE_OK)
+         throw Exception( "Unable to set data: " + body );
+
+   } else {
+      if (curl_easy_setopt( h, CURLOPT_READFUNCTION, reader ) != CURLE_OK)
+         throw Exception( "Unable to set read function" );
+
+      if (curl_easy_setopt( h, CURLOPT_READDATA, &body ) != CURLE_OK)
+         throw Exception( "Unable to set data: " + body );
+   }
+
+   if (curl_easy_setopt( h, CURLOPT_UPLOAD, 1L ) != CURLE_OK)
+      throw Exception( "Unable to set upload request" );
+
+   //     : curl  
+   //  (Transfer-Encoding: chunked)
+   if (curl_easy_setopt( h, CURLOPT_INFILESIZE, compress ? -1L : static_cast< long >( body.size() ) ) != CURLE_OK)
+      throw Exception( "Unable to set content size" );
+
+   return gzip;
+}
+
+
+
+
 Communication::Communication() {
    init( DEFAULT_COUCHDB_URL );
 }
@@ -129,16 +370,50 @@ Communication::Communication( const std::string& url ) {
 
 
 
-void Communication::init( const std::string& url ) {
-   curl_global_init( CURL_GLOBAL_DEFAULT );
+
+Communication::Communication( const std::string& url, const std::string& unixSocket ) {
+   init( url, unixSocket );
+}
+
+
+
+
+void Communication::init( const std::string& url, const std::string& unixSocket ) {
+   boost::call_once( shareOnce, initShare );
+
+   lastStatus = 0;
+   hedgeCurl = nullptr;
+   multi = nullptr;
+   batchMulti = nullptr;
+   compressRequests = false;
+   compressThreshold = 64 * 1024;
+   compressLevel = Z_DEFAULT_COMPRESSION;
+   retryTokens = policy.budgetMax;
+   random.seed( static_cast< unsigned int >( reinterpret_cast< size_t >( this ) ) );
+   latencies.reserve( 256 );
+   latencyPos = 0;
 
    curl = curl_easy_init();
    if ( !curl )
       throw Exception( "Unable to create CURL object" );
 
-   if (curl_easy_setopt( curl, CURLOPT_NOPROGRESS, 1L ) != CURLE_OK)
+   if ( share && (curl_easy_setopt( curl, CURLOPT_SHARE, share ) != CURLE_OK) )
+      throw Exception( "Unable to set SHARE option." );
+
+   if (curl_easy_setopt( curl, CURLOPT_NOPROGRESS, 0L ) != CURLE_OK)
       throw Exception( "Unable to set NOPROGRESS option." );
 
+#if LIBCURL_VERSION_NUM >= 0x072000
+   if (curl_easy_setopt( curl, CURLOPT_XFERINFOFUNCTION, progress ) != CURLE_OK)
+      throw Exception( "Unable to set progress function" );
+#else
+   if (curl_easy_setopt( curl, CURLOPT_PROGRESSFUNCTION, progress ) != CURLE_OK)
+      throw Exception( "Unable to set progress function" );
+#endif
+
+   if (curl_easy_setopt( curl, CURLOPT_PROGRESSDATA, &currentDeadline ) != CURLE_OK)
+      throw Exception( "Unable to set progress data" );
+
 #ifdef _DEBUG
    // @test
    curl_easy_setopt( curl, CURLOPT_VERBOSE, 1L );
@@ -151,6 +426,12 @@ void Communication::init( const std::string& url ) {
    if (curl_easy_setopt( curl, CURLOPT_WRITEDATA, &buffer ) != CURLE_OK)
       throw Exception( "Unable to set write buffer" );
 
+   if (curl_easy_setopt( curl, CURLOPT_HEADERFUNCTION, headerWriter ) != CURLE_OK)
+      throw Exception( "Unable to set header function" );
+
+   if (curl_easy_setopt( curl, CURLOPT_HEADERDATA, &lastHeaders ) != CURLE_OK)
+      throw Exception( "Unable to set header buffer" );
+
    if (curl_easy_setopt( curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1 ) != CURLE_OK)
       throw Exception( "Unable to set http-version" );
 
@@ -160,14 +441,25 @@ void Communication::init( const std::string& url ) {
    if (curl_easy_setopt( curl, CURLOPT_FAILONERROR, 0 ) != CURLE_OK)
       throw Exception( "Unable to set FAILONERROR option." );
 
-   // (!)    CouchDB    
-   // . . :   :)
-   if (curl_easy_setopt( curl, CURLOPT_TIMEOUT, 10 ) != CURLE_OK)
+   // @see DEFAULT_TIMEOUT
+   if (curl_easy_setopt( curl, CURLOPT_TIMEOUT_MS, DEFAULT_TIMEOUT ) != CURLE_OK)
       throw Exception( "Unable to set TIMEOUT option." );
 
    if (curl_easy_setopt( curl, CURLOPT_ENCODING, "gzip,deflate" ) != CURLE_OK)
       throw Exception( "Unable to set ENCODING option" );
 
+   if ( !unixSocket.empty() ) {
+#if LIBCURL_VERSION_NUM >= 0x072800
+      // (!)  'curl' (,  )   
+      //   .      ,
+      //  TCP.
+      if (curl_easy_setopt( curl, CURLOPT_UNIX_SOCKET_PATH, unixSocket.c_str() ) != CURLE_OK)
+         throw Exception( "Unable to set UNIX_SOCKET_PATH option: " + unixSocket );
+#else
+      throw Exception( "Unix sockets are not supported by this version of curl" );
+#endif
+   }
+
    baseURL = url;
 }
 
@@ -175,10 +467,19 @@ void Communication::init( const std::string& url ) {
 
 
 Communication::~Communication() {
+    resetCopies();
+    if ( multi ) {
+        curl_multi_cleanup( multi );
+    }
+    if ( batchMulti ) {
+        curl_multi_cleanup( batchMulti );
+    }
     if ( curl ) {
         curl_easy_cleanup( curl );
     }
+    /* -    curl    . . initShare().
     curl_global_cleanup();
+    */
 }
 
 
@@ -217,12 +518,56 @@ std::string Communication::getRawData( const std::string& url ) {
 
 
 
+std::string Communication::getRawData( const std::string& url, const HeaderMap& headers ) {
+   getRawData( url, "GET", "", headers );
+   return buffer;
+}
+
+
+
+
+long Communication::responseStatus() const {
+   return lastStatus;
+}
+
+
+
+
+const Communication::HeaderMap& Communication::responseHeaders() const {
+   return lastHeaders;
+}
+
+
+
+
 Variant Communication::getData(
     const std::string& url,
     const std::string& method,
     std::string data,
     const HeaderMap &headers
 ) {
+   //      , ,  
+   // @see setSingleflight()
+   if ( flightGroup && data.empty() && headers.empty()
+     && ( (method == "GET") || (method == "HEAD") )
+   ) {
+       const Singleflight::Response response = flightGroup->run(
+           method + " " + baseURL + url,
+           [ this, &url, &method ] () -> Singleflight::Response {
+               getRawData( url, method, "", HeaderMap() );
+               Singleflight::Response r;
+               r.data = parseData( buffer );
+               r.status = lastStatus;
+               r.headers = lastHeaders;
+               return r;
+           },
+           currentDeadline
+       );
+       lastStatus = response.status;
+       lastHeaders = response.headers;
+       return response.data;
+   }
+
    getRawData( url, method, data, headers );
    return parseData( buffer );
 }
@@ -230,37 +575,36 @@ Variant Communication::getData(
 
 
 
-void Communication::getRawData(
-    const std::string& _url,
-    const std::string& method,
-    const std::string& data,
-    const HeaderMap& headers
-) {
-   /* - .    .
-   std::string preparedURL = curl_easy_escape( curl, _url.c_str(), _url.length() );
-   boost::replace_all( preparedURL, "%26", "&" );
-   boost::replace_all( preparedURL, "%2F", "/" );
-   boost::replace_all( preparedURL, "%3D", "=" );
-   boost::replace_all( preparedURL, "%3F", "?" );
-   const std::string url = baseURL + preparedURL;
-   */
-   const std::string url = baseURL + _url;
+void Communication::setSingleflight( std::shared_ptr< Singleflight > group ) {
+   flightGroup = group;
+}
 
-   const bool presentData = !data.empty();
 
-   //  -  .    .
-   const auto needSafe = [] ( const std::string& s ) -> bool {
-       for (auto itr = s.cbegin(); itr != s.cend(); ++itr) {
-           const char ch = *itr;
-           //  
-           if ( ( (ch >= '' ) && (ch <= '') ) || ( (ch >= '' ) && (ch <= '') ) ) {
-               return true;
-           }
+
+
+std::shared_ptr< Singleflight > Communication::singleflight() const {
+   return flightGroup;
+}
+
+
+
+
+bool Communication::needSafe( const std::string& s ) {
+   for (auto itr = s.cbegin(); itr != s.cend(); ++itr) {
+       const char ch = *itr;
+       //  
+       if ( ( (ch >= '' ) && (ch <= '') ) || ( (ch >= '' ) && (ch <= '') ) ) {
+           return true;
        }
-       return false;
-   };
+   }
+   return false;
+}
 
 
+
+
+std::string Communication::prepareData( const std::string& data ) const {
+   //  -  .    .
    std::string preparedData;
    if ( needSafe( data ) ) {
        // @todo fine optimize        ?
@@ -305,7 +649,9 @@ void Communication::getRawData(
        } );
        curl_free( preparedDataPtr );
        */
-       preparedData = curl_easy_escape( curl, data.c_str(), data.length() );
+       char* preparedDataPtr = curl_easy_escape( curl, data.c_str(), data.length() );
+       preparedData = preparedDataPtr;
+       curl_free( preparedDataPtr );
        std::for_each( FROM_RFC1738.cbegin(), FROM_RFC1738.cend(),
            [ &preparedData ] ( const std::map< std::string, std::string >::value_type&  code ) {
                boost::replace_all( preparedData, code.first, code.second );
@@ -320,12 +666,44 @@ void Communication::getRawData(
        preparedData = data;
    }
 
+   return preparedData;
+}
+
+
+
+
+
+void Communication::getRawData(
+    const std::string& _url,
+    const std::string& method,
+    const std::string& data,
+    const HeaderMap& headers
+) {
+   /* - .    .
+   std::string preparedURL = curl_easy_escape( curl, _url.c_str(), _url.length() );
+   boost::replace_all( preparedURL, "%26", "&" );
+   boost::replace_all( preparedURL, "%2F", "/" );
+   boost::replace_all( preparedURL, "%3D", "=" );
+   boost::replace_all( preparedURL, "%3F", "?" );
+   const std::string url = baseURL + preparedURL;
+   */
+   const std::string url = baseURL + _url;
+
+   checkDeadline( url );
+
+   const bool presentData = !data.empty();
+
+   // (!)  const: reader()     .
+   std::string preparedData = prepareData( data );
+
    //    
    /* -  :      .
    boost::replace_all( preparedData, "\n", "\\n" );
    */
 
-   const long sizePreparedData = static_cast< long >( preparedData.size() );
+   //     , . setRequestCompression()
+   const bool compress =
+       presentData && compressRequests && (preparedData.size() >= compressThreshold);
 
 
 #ifdef COUCHFINE_DEBUG
@@ -333,9 +711,11 @@ void Communication::getRawData(
 #endif
 
    buffer.clear();
+   lastStatus = 0;
+   lastHeaders.clear();
 
+   struct curl_slist* chunk = nullptr;
    if ( !headers.empty() || presentData ) {
-      struct curl_slist* chunk = nullptr;
 
       HeaderMap::const_iterator header = headers.begin();
       const HeaderMap::const_iterator& headerEnd = headers.end();
@@ -352,6 +732,10 @@ void Communication::getRawData(
             chunk = curl_slist_append( chunk, "charsets: utf-8" );
       }
 
+      if ( compress ) {
+            chunk = curl_slist_append( chunk, "Content-Encoding: gzip" );
+      }
+
       if (curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk) != CURLE_OK)
           throw Exception( "Unable to set custom header" );
    }
@@ -362,28 +746,19 @@ void Communication::getRawData(
    if (curl_easy_setopt(curl, CURLOPT_URL, url.c_str()) != CURLE_OK)
       throw Exception( "Unable to set URL: " + url );
 
+   std::shared_ptr< GzipReader >  gzip;
    if( presentData ) {
 #ifdef COUCHFINE_DEBUG
       //std::cout << "Sending data: " << preparedData << std::endl;
 #endif
-
-      if (curl_easy_setopt(curl, CURLOPT_READFUNCTION, reader) != CURLE_OK)
-         throw Exception( "Unable to set read function" );
-
-      if (curl_easy_setopt(curl, CURLOPT_READDATA, &preparedData) != CURLE_OK)
-         throw Exception( "Unable to set data: " + preparedData);
-
-      if (curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L) != CURLE_OK)
-         throw Exception( "Unable to set upload request" );
-
-      if (curl_easy_setopt(curl, CURLOPT_INFILESIZE, sizePreparedData) != CURLE_OK)
-         throw Exception( "Unable to set content size" );
+      gzip = setBody( curl, preparedData, compress, compressLevel );
    }
 
    /* - . . .
    if(curl_easy_perform(curl) != CURLE_OK)
       throw Exception("Unable to load URL: " + url);
    */
+   /* -   . . .
    const auto errorPerform = curl_easy_perform( curl );
    if (errorPerform != CURLE_OK) {
        CURLINFO info = CURLINFO_NONE;
@@ -392,9 +767,49 @@ void Communication::getRawData(
        std::cerr << strError << std::endl;
        throw Exception( "Unable to load URL: " + url );
    }
+   */
+   //     .    
+   // ,  'preparedData'   .
+   const bool idempotent = !presentData && ( (method == "GET") || (method == "HEAD") );
+   //     ,  -   GET
+   const bool hedge = idempotent && headers.empty() && (method == "GET") && policy.hedge;
+
+   retryTokens = std::min( retryTokens + policy.budgetRatio, policy.budgetMax );
+
+   typedef boost::chrono::steady_clock  clock_t;
+   CURLcode errorPerform = CURLE_OK;
+   long status = 0;
+   for (size_t attempt = 0; ; ++attempt) {
+       if (curl_easy_setopt( curl, CURLOPT_TIMEOUT_MS, timeout() ) != CURLE_OK)
+          throw Exception( "Unable to set TIMEOUT option." );
+
+       const clock_t::time_point start = clock_t::now();
+       errorPerform = perform( url, hedge, &status );
+       if ( idempotent && (errorPerform == CURLE_OK) && (status < 500) ) {
+           addLatency( boost::chrono::duration< double, boost::milli >( clock_t::now() - start ).count() );
+       }
+       if ( !idempotent
+         || !retryable( errorPerform, status )
+         || (attempt + 1 >= policy.maxAttempts)
+         || currentDeadline.over()
+         || !takeRetryToken()
+       ) {
+           break;
+       }
+       const size_t pause = backoff( attempt );
+       if ( !currentDeadline.infinite() && (pause >= currentDeadline.remaining()) ) {
+           break;
+       }
+       boost::this_thread::sleep_for( boost::chrono::milliseconds( pause ) );
+       buffer.clear();
+       lastHeaders.clear();
+   }
+   lastStatus = status;
 
 
    if ( presentData || !headers.empty() ) {
+      curl_slist_free_all( chunk );
+
       if (curl_easy_setopt( curl, CURLOPT_UPLOAD, 0L ) != CURLE_OK)
          throw Exception( "Unable to reset upload request" );
 
@@ -402,6 +817,16 @@ void Communication::getRawData(
          throw Exception( "Unable to reset custom headers" );
    }
 
+   if (errorPerform != CURLE_OK) {
+       checkDeadline( url );
+       if ( (errorPerform == CURLE_OPERATION_TIMEDOUT) && !currentDeadline.infinite() ) {
+           throw Exception( "Deadline exceeded: " + url );
+       }
+       const std::string strError = curl_easy_strerror( errorPerform );
+       std::cerr << strError << std::endl;
+       throw Exception( "Unable to load URL: " + url + " (" + strError + ")" );
+   }
+
 #ifdef COUCHFINE_DEBUG
    long responseCode;
    if (curl_easy_getinfo( curl, CURLINFO_RESPONSE_CODE, &responseCode ) != CURLE_OK)
@@ -412,3 +837,447 @@ void Communication::getRawData(
 #endif
 
 }
+
+
+
+
+void Communication::setRetryPolicy( const RetryPolicy& p ) {
+   policy = p;
+   retryTokens = std::min( retryTokens, policy.budgetMax );
+}
+
+
+
+
+const RetryPolicy& Communication::retryPolicy() const {
+   return policy;
+}
+
+
+
+
+CURLcode Communication::perform( const std::string& url, bool hedge, long* status ) {
+   const double delay = hedge ? hedgeDelay() : 0.0;
+   if (delay > 0.0) {
+       return performHedged( url, delay, status );
+   }
+
+   const CURLcode result = curl_easy_perform( curl );
+   *status = 0;
+   if (result == CURLE_OK) {
+       curl_easy_getinfo( curl, CURLINFO_RESPONSE_CODE, status );
+   }
+   return result;
+}
+
+
+
+
+CURLcode Communication::performHedged( const std::string& url, double delay, long* status ) {
+   *status = 0;
+   if ( !multi ) {
+       multi = curl_multi_init();
+   }
+   //     ,    : ,
+   //   ..      .
+   if ( multi && !hedgeCurl ) {
+       hedgeCurl = curl_easy_duphandle( curl );
+   }
+   if ( !multi || !hedgeCurl ) {
+       return perform( url, false, status );
+   }
+   curl_easy_setopt( hedgeCurl, CURLOPT_URL, url.c_str() );
+   curl_easy_setopt( hedgeCurl, CURLOPT_TIMEOUT_MS, timeout() );
+   curl_easy_setopt( hedgeCurl, CURLOPT_WRITEDATA, &hedgeBuffer );
+   curl_easy_setopt( hedgeCurl, CURLOPT_HEADERDATA, &hedgeHeaders );
+   hedgeBuffer.clear();
+   hedgeHeaders.clear();
+
+   typedef boost::chrono::steady_clock  clock_t;
+   const clock_t::time_point start = clock_t::now();
+
+   curl_multi_add_handle( multi, curl );
+   bool hedged = false;
+   size_t running = 1;
+   CURL* winner = nullptr;
+   CURLcode result = CURLE_OK;
+   long winnerStatus = 0;
+   while ( !winner && (running > 0) && !currentDeadline.cancelled() ) {
+       int stillRunning = 0;
+       curl_multi_perform( multi, &stillRunning );
+
+       int left = 0;
+       for (CURLMsg* msg = curl_multi_info_read( multi, &left ); msg; msg = curl_multi_info_read( multi, &left )) {
+           if (msg->msg != CURLMSG_DONE) {
+               continue;
+           }
+           --running;
+           long code = 0;
+           curl_easy_getinfo( msg->easy_handle, CURLINFO_RESPONSE_CODE, &code );
+           //    -      ,
+           //     ,   .
+           const bool ok = (msg->data.result == CURLE_OK) && (code < 500);
+           if ( ok || (running == 0) ) {
+               winner = msg->easy_handle;
+               result = msg->data.result;
+               winnerStatus = code;
+               break;
+           }
+       }
+       if ( winner ) {
+           break;
+       }
+
+       const double elapsed =
+           boost::chrono::duration< double, boost::milli >( clock_t::now() - start ).count();
+       if ( !hedged && (running > 0) && (elapsed >= delay) ) {
+           hedged = true;
+           if ( takeRetryToken() ) {
+               curl_multi_add_handle( multi, hedgeCurl );
+               ++running;
+               continue;
+           }
+       }
+
+       const int timeout = hedged
+           ? 100
+           : std::max( 1, std::min( 100, static_cast< int >( delay - elapsed ) ) );
+       waitMulti( multi, timeout );
+   }
+
+   // (!)     
+   curl_multi_remove_handle( multi, curl );
+   if ( hedged ) {
+       curl_multi_remove_handle( multi, hedgeCurl );
+   }
+
+   if ( !winner ) {
+       result = CURLE_ABORTED_BY_CALLBACK;
+   }
+   if (winner == hedgeCurl) {
+       buffer.swap( hedgeBuffer );
+       lastHeaders.swap( hedgeHeaders );
+   }
+   hedgeBuffer.clear();
+   hedgeHeaders.clear();
+   *status = winnerStatus;
+   return result;
+}
+
+
+
+
+bool Communication::retryable( CURLcode result, long status ) {
+   switch ( result ) {
+       case CURLE_OK :
+           return (status >= 500);
+       case CURLE_COULDNT_RESOLVE_HOST :
+       case CURLE_COULDNT_CONNECT :
+       case CURLE_OPERATION_TIMEDOUT :
+       case CURLE_SEND_ERROR :
+       case CURLE_RECV_ERROR :
+       case CURLE_GOT_NOTHING :
+       case CURLE_PARTIAL_FILE :
+           return true;
+       default :
+           return false;
+   }
+}
+
+
+
+
+bool Communication::takeRetryToken() {
+   if (retryTokens < 1.0) {
+       return false;
+   }
+   retryTokens -= 1.0;
+   return true;
+}
+
+
+
+
+size_t Communication::backoff( size_t attempt ) {
+   // "" :     
+   size_t limit = policy.baseDelay;
+   for (size_t i = 0; (i < attempt) && (limit < policy.maxDelay); ++i) {
+       limit *= 2;
+   }
+   limit = std::min( limit, policy.maxDelay );
+   boost::random::uniform_int_distribution< size_t >  d( 0, limit );
+   return d( random );
+}
+
+
+
+
+void Communication::addLatency( double ms ) {
+   if (latencies.size() < latencies.capacity()) {
+       latencies.push_back( ms );
+   } else {
+       latencies[ latencyPos ] = ms;
+       latencyPos = (latencyPos + 1) % latencies.size();
+   }
+}
+
+
+
+
+double Communication::hedgeDelay() const {
+   if ( latencies.empty() || (latencies.size() < policy.hedgeMinSamples) ) {
+       return 0.0;
+   }
+   std::vector< double >  sorted( latencies );
+   const size_t k = std::min(
+       sorted.size() - 1,
+       static_cast< size_t >( policy.hedgePercentile * static_cast< double >( sorted.size() ) )
+   );
+   std::nth_element( sorted.begin(), sorted.begin() + k, sorted.end() );
+   return std::max( sorted[ k ], static_cast< double >( policy.hedgeMinDelay ) );
+}
+
+
+
+
+void Communication::setDeadline( const Deadline& d ) {
+   currentDeadline = d;
+}
+
+
+
+
+const Deadline& Communication::deadline() const {
+   return currentDeadline;
+}
+
+
+
+
+long Communication::timeout() const {
+   // (!) 0  curl - " "
+   return currentDeadline.infinite()
+       ? DEFAULT_TIMEOUT
+       : std::max( 1L, static_cast< long >( currentDeadline.remaining() ) );
+}
+
+
+
+
+void Communication::checkDeadline( const std::string& url ) const {
+   if ( currentDeadline.cancelled() ) {
+       throw Exception( "Operation cancelled: " + url );
+   }
+   if ( currentDeadline.expired() ) {
+       throw Exception( "Deadline exceeded: " + url );
+   }
+}
+
+
+
+
+void Communication::resetCopies() {
+   if ( hedgeCurl ) {
+       curl_easy_cleanup( hedgeCurl );
+       hedgeCurl = nullptr;
+   }
+   for (auto itr = batchCurl.begin(); itr != batchCurl.end(); ++itr) {
+       curl_easy_cleanup( *itr );
+   }
+   batchCurl.clear();
+}
+
+
+
+
+void Communication::setProtocol( Protocol protocol ) {
+   long version = CURL_HTTP_VERSION_1_1;
+   switch ( protocol ) {
+       case HTTP_1_1 :
+           break;
+#if LIBCURL_VERSION_NUM >= 0x073100
+       case HTTP_2_TLS :
+           version = CURL_HTTP_VERSION_2TLS;
+           break;
+       case HTTP_2_PRIOR_KNOWLEDGE :
+           version = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+           break;
+#endif
+       default :
+           throw Exception( "HTTP/2 is not supported by this version of curl" );
+   }
+
+   if (curl_easy_setopt( curl, CURLOPT_HTTP_VERSION, version ) != CURLE_OK)
+      throw Exception( "Unable to set http-version" );
+
+   //  'curl'      
+   resetCopies();
+}
+
+
+
+
+namespace {
+
+/**
+*     getDataBatch().
+*/
+struct Transfer {
+    size_t index;
+    std::string body;
+    std::string response;
+    struct curl_slist* headers;
+    //   , . setBody()
+    std::shared_ptr< GzipReader >  gzip;
+
+    inline Transfer() : index( 0 ), headers( nullptr ) {
+    }
+};
+
+} // namespace
+
+
+
+
+std::vector< Variant >  Communication::getDataBatch(
+    const std::vector< Request >& requests,
+    size_t concurrency
+) {
+   std::vector< Variant >  result( requests.size() );
+   if ( requests.empty() ) {
+       return result;
+   }
+   checkDeadline( baseURL );
+
+   if ( !batchMulti ) {
+       batchMulti = curl_multi_init();
+       if ( !batchMulti )
+          throw Exception( "Unable to create CURLM object" );
+#if LIBCURL_VERSION_NUM >= 0x072B00
+       // HTTP/2:        
+       curl_multi_setopt( batchMulti, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX );
+#endif
+   }
+
+   const size_t n = std::max< size_t >( 1, std::min( concurrency, requests.size() ) );
+   while (batchCurl.size() < n) {
+       //     'curl':  HTTP, ,
+       //  , 
+       CURL* h = curl_easy_duphandle( curl );
+       if ( !h )
+          throw Exception( "Unable to create CURL object" );
+       //      
+       curl_easy_setopt( h, CURLOPT_HEADERDATA, NULL );
+       batchCurl.push_back( h );
+   }
+   std::vector< Transfer >  transfers( n );
+
+   //   'i'   'slot'
+   const auto start = [ this, &requests, &transfers ] ( size_t slot, size_t i ) {
+       CURL* h = batchCurl[ slot ];
+       Transfer& t = transfers[ slot ];
+       const Request& request = requests[ i ];
+       const std::string url = baseURL + request.url;
+       t.index = i;
+       t.response.clear();
+       t.body = prepareData( request.data );
+       t.gzip.reset();
+       curl_slist_free_all( t.headers );
+       t.headers = nullptr;
+
+       curl_easy_setopt( h, CURLOPT_URL, url.c_str() );
+       curl_easy_setopt( h, CURLOPT_CUSTOMREQUEST, request.method.c_str() );
+       curl_easy_setopt( h, CURLOPT_WRITEDATA, &t.response );
+       curl_easy_setopt( h, CURLOPT_PRIVATE, &t );
+       curl_easy_setopt( h, CURLOPT_TIMEOUT_MS, timeout() );
+#if LIBCURL_VERSION_NUM >= 0x072B00
+       //  ,   ,    
+       curl_easy_setopt( h, CURLOPT_PIPEWAIT, 1L );
+#endif
+       if ( request.data.empty() ) {
+           curl_easy_setopt( h, CURLOPT_UPLOAD, 0L );
+           curl_easy_setopt( h, CURLOPT_HTTPHEADER, NULL );
+       } else {
+           //  -   getRawData()
+           const bool compress = compressRequests && (t.body.size() >= compressThreshold);
+           t.headers = curl_slist_append( t.headers, "Accept: application/json" );
+           t.headers = curl_slist_append( t.headers, "Content-Type: application/json" );
+           if ( compress ) {
+               t.headers = curl_slist_append( t.headers, "Content-Encoding: gzip" );
+           }
+           curl_easy_setopt( h, CURLOPT_HTTPHEADER, t.headers );
+           t.gzip = setBody( h, t.body, compress, compressLevel );
+       }
+       curl_multi_add_handle( batchMulti, h );
+   };
+
+   size_t next = 0;
+   size_t running = 0;
+   for ( ; next < n; ++next, ++running) {
+       start( next, next );
+   }
+
+   while ( (running > 0) && !currentDeadline.cancelled() ) {
+       int stillRunning = 0;
+       curl_multi_perform( batchMulti, &stillRunning );
+
+       int left = 0;
+       for (CURLMsg* msg = curl_multi_info_read( batchMulti, &left ); msg; msg = curl_multi_info_read( batchMulti, &left )) {
+           if (msg->msg != CURLMSG_DONE) {
+               continue;
+           }
+           CURL* h = msg->easy_handle;
+           Transfer* t = nullptr;
+           curl_easy_getinfo( h, CURLINFO_PRIVATE, reinterpret_cast< char** >( &t ) );
+           std::string reason;
+           if (msg->data.result == CURLE_OK) {
+               try {
+                   result[ t->index ] = parseData( t->response );
+               } catch ( ... ) {
+                   reason = "Unable to parse response";
+               }
+           } else {
+               reason = curl_easy_strerror( msg->data.result );
+           }
+           if ( !reason.empty() ) {
+               Object o;
+               o[ "error" ] = typelib::json::cjv( std::string( "transport" ) );
+               o[ "reason" ] = typelib::json::cjv( reason );
+               result[ t->index ] = typelib::json::cjv( o );
+           }
+           curl_multi_remove_handle( batchMulti, h );
+           --running;
+
+           if (next < requests.size()) {
+               start( static_cast< size_t >( t - &transfers.front() ), next );
+               ++next;
+               ++running;
+           }
+       }
+
+       if (running > 0) {
+           waitMulti( batchMulti, 100 );
+       }
+   }
+
+   //  ,   
+   for (size_t slot = 0; slot < n; ++slot) {
+       curl_multi_remove_handle( batchMulti, batchCurl[ slot ] );
+       curl_slist_free_all( transfers[ slot ].headers );
+       curl_easy_setopt( batchCurl[ slot ], CURLOPT_HTTPHEADER, NULL );
+   }
+   if (running > 0) {
+       checkDeadline( baseURL );
+   }
+
+   return result;
+}
+
+
+
+
+void Communication::setRequestCompression( bool enable, size_t threshold, int level ) {
+   compressRequests = enable;
+   compressThreshold = threshold;
+   compressLevel = level;
+}
@@ -16,6 +16,14 @@ Connection::Connection( const std::string& url ) : comm( url ) {
 
 
 
+Connection::Connection( const std::string& url, const std::string& unixSocket ) :
+    comm( url, unixSocket )
+{
+   getInfo();
+}
+
+
+
 void Connection::getInfo() {
    const Variant var = comm.getData( "" );
    const Object obj = boost::any_cast< Object >( *var );
@@ -99,9 +107,11 @@ bool Connection::deleteDatabase(const std::string& db) {
 
 void Connection::clearDatabase( const std::string& name, bool includeDesign ) {
 
+    /* -    . . . clearDatabases().
     if ( !existsDatabase( name ) ) {
         throw "Database '" + name + "' not found.";
     }
+    */
 
     /* -  . . . .
     //     design-
@@ -140,52 +150,7 @@ void Connection::clearDatabase( const std::string& name, bool includeDesign ) {
     }
     */
 
-    //  design-
-    Array designRows;
-    if ( !includeDesign ) {
-        // @todo ,   design-  .   .
-        //   design-
-        const Variant var = comm.getData( "/" + name + "/_all_docs?startkey=\"_design/\"&endkey=\"_design0\"" );
-        const Object obj = boost::any_cast< Object >( *var );
-        const Array rows = boost::any_cast< Array >( *obj.at( "rows" ) );
-        for (auto itr = rows.cbegin(); itr != rows.cend(); ++itr) {
-            const Object doc = boost::any_cast< Object >( **itr );
-            const Object value = boost::any_cast< Object >( *doc.at( "value" ) );
-            const uid_t& id = CouchFine::uid( doc );
-            const rev_t& rev = CouchFine::revision( value );
-            //  
-            const Variant var = comm.getData( "/" + name + "/" + id + "?rev=" + rev );
-            const Object obj = boost::any_cast< Object >( *var );
-            if ( hasError( obj ) ) {
-                throw error( obj );
-            }
-            designRows.push_back( var );
-        }
-    }
-
-    //  
-    deleteDatabase( name );
-    createDatabase( name );
-
-    //  design-
-    // (!)       .
-    for (auto itr = designRows.cbegin(); itr != designRows.cend(); ++itr) {
-        Object doc = boost::any_cast< Object >( **itr );
-        //const std::string id = boost::any_cast< std::string> ( *doc["_id"] );
-        //doc.erase( "_id" );
-        doc.erase( "_rev" );
-
-        std::ostringstream os;
-        os << typelib::json::cjv( doc );
-        const std::string json = os.str();
-        //std::cout << json << std::endl;
-
-        const Variant var = comm.getData( "/" + name, "POST",  json );
-        const Object obj = boost::any_cast< Object >( *var );
-        if ( hasError( obj ) ) {
-            throw Exception( "Document could not be created: " + error( obj ) );
-        }
-    }
+    clearDatabases( std::vector< std::string >( 1, name ), includeDesign );
 
 
     /* - @test
@@ -202,3 +167,112 @@ void Connection::clearDatabase( const std::string& name, bool includeDesign ) {
     */
 
 }
+
+
+
+
+void Connection::clearDatabases( const std::vector< std::string >&  names, bool includeDesign ) {
+
+    //  design-.  ,   .
+    // @todo ,   design-  .   .
+    std::vector< Communication::Request >  requests;
+    for (auto itr = names.cbegin(); itr != names.cend(); ++itr) {
+        requests.push_back( Communication::Request( includeDesign
+            ? "/" + *itr
+            : "/" + *itr + "/_all_docs?include_docs=true&startkey=\"_design/\"&endkey=\"_design0\""
+        ) );
+    }
+    const std::vector< Variant >  designs = comm.getDataBatch( requests );
+    for (size_t i = 0; i < names.size(); ++i) {
+        if ( hasError( designs[ i ] ) ) {
+            //   clearDatabase():   - 
+            const Object o = boost::any_cast< Object >( *designs[ i ] );
+            if (v< std::string >( o, "error" ) == "not_found") {
+                throw "Database '" + names[ i ] + "' not found.";
+            }
+            throw Exception( "Database '" + names[ i ] + "': " + error( designs[ i ] ) );
+        }
+    }
+
+    //   :     
+    //     design-,    
+    //  -  
+    std::string failed;
+    const auto fail = [ &failed ] ( const std::string& e ) {
+        failed += (failed.empty() ? "" : "; ") + e;
+    };
+
+    //  
+    requests.clear();
+    for (auto itr = names.cbegin(); itr != names.cend(); ++itr) {
+        requests.push_back( Communication::Request( "/" + *itr, "DELETE" ) );
+    }
+    std::vector< Variant >  responses = comm.getDataBatch( requests );
+    //     :   design-.  
+    std::vector< size_t >  deleted;
+    requests.clear();
+    for (size_t i = 0; i < names.size(); ++i) {
+        if ( hasError( responses[ i ] ) ) {
+            fail( "Unable to delete database '" + names[ i ] + "': " + error( responses[ i ] ) );
+            continue;
+        }
+        requests.push_back( Communication::Request( "/" + names[ i ], "PUT" ) );
+        deleted.push_back( i );
+    }
+    responses = comm.getDataBatch( requests );
+    std::vector< size_t >  created;
+    for (size_t k = 0; k < responses.size(); ++k) {
+        if ( hasError( responses[ k ] ) ) {
+            fail( "Unable to create database '" + names[ deleted[ k ] ] + "': " + error( responses[ k ] ) );
+        } else {
+            created.push_back( deleted[ k ] );
+        }
+    }
+
+    //  design-:    
+    // (!)       .
+    requests.clear();
+    std::vector< size_t >  index;
+    for (auto ctr = created.cbegin(); !includeDesign && (ctr != created.cend()); ++ctr) {
+        const size_t i = *ctr;
+        Object o = boost::any_cast< Object >( *designs[ i ] );
+        const Array rows = static_cast< Array >( o[ "rows" ] );
+        Array docs;
+        for (auto itr = rows.cbegin(); itr != rows.cend(); ++itr) {
+            const Object row = boost::any_cast< Object >( **itr );
+            const auto ftr = row.find( "doc" );
+            if ( (ftr == row.cend()) || !ftr->second || (ftr->second->type() != typeid( Object )) ) {
+                continue;
+            }
+            Object doc = boost::any_cast< Object >( *ftr->second );
+            doc.erase( "_rev" );
+            docs.push_back( typelib::json::cjv( doc ) );
+        }
+        if ( docs.empty() ) {
+            continue;
+        }
+        Object body;
+        body[ "docs" ] = typelib::json::cjv( docs );
+        std::ostringstream os;
+        os << typelib::json::cjv( body );
+        requests.push_back( Communication::Request( "/" + names[ i ] + "/_bulk_docs", "POST", os.str() ) );
+        index.push_back( i );
+    }
+    responses = comm.getDataBatch( requests );
+    for (size_t k = 0; k < responses.size(); ++k) {
+        if ( hasError( responses[ k ] ) ) {
+            fail( "Document could not be created in '" + names[ index[ k ] ] + "': " + error( responses[ k ] ) );
+            continue;
+        }
+        const Array ra = boost::any_cast< Array >( *responses[ k ] );
+        for (auto itr = ra.cbegin(); itr != ra.cend(); ++itr) {
+            if ( hasError( *itr ) ) {
+                fail( "Document could not be created in '" + names[ index[ k ] ] + "': " + error( *itr ) );
+            }
+        }
+    }
+
+    if ( !failed.empty() ) {
+        throw Exception( failed );
+    }
+}
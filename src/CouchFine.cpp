@@ -1,9 +1,205 @@
 #include "../include/CouchFine.h"
+#include <set>
+#include <boost/thread/mutex.hpp>
 
 
 namespace CouchFine {
 
 
+namespace {
+
+/**
+* Design-    _update, 
+*   Mode::AppendNewOnly / Mode::AppendUpdate.
+*
+*   -  , 'mode=update' - 
+*  .   ,   
+* . : {"ok": true, "id": ..., "changed": ...}.
+*
+* (!)       .
+*/
+const std::string APPEND_DESIGN = "couchfine";
+const std::string APPEND_HANDLER = "append";
+const std::string APPEND_SOURCE =
+    "function( doc, req ) {"
+        " var data = JSON.parse( req.body || '{}' );"
+        " var update = (req.query.mode == 'update');"
+        " var changed = false;"
+        " if ( !doc ) {"
+            " doc = { _id: req.id || data._id || req.uuid };"
+            " changed = true;"
+        " }"
+        " var isObject = function( v ) {"
+            " return (v !== null) && (typeof v == 'object') && !(v instanceof Array);"
+        " };"
+        " var merge = function( target, source ) {"
+            " for (var k in source) {"
+                " if ( (k == '_id') || (k == '_rev') ) { continue; }"
+                " if ( isObject( target[ k ] ) && isObject( source[ k ] ) ) {"
+                    " merge( target[ k ], source[ k ] );"
+                " } else if ( !(k in target) || (update && (JSON.stringify( target[ k ] ) != JSON.stringify( source[ k ] ))) ) {"
+                    " target[ k ] = source[ k ];"
+                    " changed = true;"
+                " }"
+            " }"
+        " };"
+        " merge( doc, data );"
+        " return [ changed ? doc : null, JSON.stringify( { ok: true, id: doc._id, changed: changed } ) ];"
+    " }";
+
+//    :      
+//     
+const size_t APPEND_RETRY = 5;
+
+
+// ,     : (Communication, )
+boost::mutex appendLock;
+std::set< std::pair< const Communication*, std::string > >  appendInstalled;
+
+
+
+
+/**
+*   _update,       .
+*/
+void installAppendHandler( Database& store, bool force ) {
+    const auto key = std::make_pair( &store.getCommunication(), store.getName() );
+    {
+        boost::mutex::scoped_lock lock( appendLock );
+        if ( !force && (appendInstalled.count( key ) > 0) ) {
+            return;
+        }
+    }
+
+    Communication& comm = store.getCommunication();
+    const std::string url = "/" + store.getName() + "/" + store.getDesignUID( APPEND_DESIGN );
+    for (size_t attempt = 0; ; ++attempt) {
+        const Variant var = comm.getData( url );
+        Object design;
+        if ( !hasError( var ) ) {
+            design = boost::any_cast< Object >( *var );
+        }
+        Object updates;
+        const auto ftr = design.find( "updates" );
+        if ( (ftr != design.cend()) && (ftr->second->type() == typeid( Object )) ) {
+            updates = boost::any_cast< Object >( *ftr->second );
+        }
+        const auto htr = updates.find( APPEND_HANDLER );
+        if ( (htr != updates.cend()) && (boost::any_cast< std::string >( *htr->second ) == APPEND_SOURCE) ) {
+            break;
+        }
+
+        design[ "_id" ] = typelib::json::cjv( store.getDesignUID( APPEND_DESIGN ) );
+        design[ "language" ] = typelib::json::cjv( std::string( "javascript" ) );
+        updates[ APPEND_HANDLER ] = typelib::json::cjv( APPEND_SOURCE );
+        design[ "updates" ] = typelib::json::cjv( updates );
+        std::ostringstream ss;
+        ::operator<<( ss, typelib::json::cjv( design ) );
+        const Variant r = comm.getData( url, "PUT", ss.str() );
+        if ( !hasError( r ) ) {
+            break;
+        }
+        //     - 
+        if (attempt >= APPEND_RETRY) {
+            throw Exception( "Update handler could not be installed: " + error( r ) );
+        }
+    }
+
+    boost::mutex::scoped_lock lock( appendLock );
+    appendInstalled.insert( key );
+}
+
+
+
+
+/**
+*     _update.
+*
+* @see Mode::AppendNewOnly
+*/
+template< typename T >
+void append( Database& store, T& doc, bool update ) {
+    // 'doc'     Object   Pool
+    assert( doc.p || doc.o );
+
+    installAppendHandler( store, false );
+
+    std::vector< Object* >  objects;
+    if ( doc.p ) {
+        for (auto itr = doc.p->cbegin(); itr != doc.p->cend(); ++itr) {
+            objects.push_back( boost::any_cast< Object* >( **itr ) );
+        }
+    } else {
+        objects.push_back( doc.o );
+    }
+
+    const std::string base = "/" + store.getName() + "/" + store.getDesignUID( APPEND_DESIGN )
+        + "/_update/" + APPEND_HANDLER;
+    const std::string query = update ? "?mode=update" : "";
+
+    //   
+    std::vector< size_t >  pending;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        pending.push_back( i );
+    }
+    std::string lastError;
+    bool reinstalled = false;
+    for (size_t attempt = 0; !pending.empty() && (attempt <= APPEND_RETRY); ++attempt) {
+        std::vector< Communication::Request >  requests;
+        for (auto itr = pending.cbegin(); itr != pending.cend(); ++itr) {
+            Object& o = *objects[ *itr ];
+            const uid_t id = hasUID( o ) ? uid( o ) : "";
+            std::ostringstream ss;
+            if ( doc.fnCreateJSON ) {
+                ss << doc.fnCreateJSON( typelib::json::cjv( o ) );
+            } else {
+                ::operator<<( ss, typelib::json::cjv( o ) );
+            }
+            requests.push_back( Communication::Request(
+                base + ( id.empty() ? "" : "/" + id ) + query, id.empty() ? "POST" : "PUT", ss.str()
+            ) );
+        }
+
+        const std::vector< Variant >  responses = store.getCommunication().getDataBatch( requests );
+        std::vector< size_t >  retry;
+        for (size_t k = 0; k < responses.size(); ++k) {
+            Object& o = *objects[ pending[ k ] ];
+            if ( !hasError( responses[ k ] ) ) {
+                const Object r = boost::any_cast< Object >( *responses[ k ] );
+                if ( !hasUID( o ) ) {
+                    uid( o, boost::any_cast< std::string >( *r.at( "id" ) ) );
+                }
+                continue;
+            }
+            const Object r = boost::any_cast< Object >( *responses[ k ] );
+            const std::string e = boost::any_cast< std::string >( *r.at( "error" ) );
+            lastError = e;
+            if (e == "conflict") {
+                //   UID: .  UID ( ) - .
+                retry.push_back( pending[ k ] );
+            } else if ( (e == "not_found") && !reinstalled ) {
+                // Design-  ( ) -  
+                retry.push_back( pending[ k ] );
+            } else {
+                throw Exception( "Append '" + uid( o ) + "': " + e );
+            }
+        }
+        if ( !retry.empty() && (lastError == "not_found") && !reinstalled ) {
+            installAppendHandler( store, true );
+            reinstalled = true;
+        }
+        pending.swap( retry );
+    }
+
+    if ( !pending.empty() ) {
+        throw Exception( "Append '" + uid( *objects[ pending.front() ] ) + "': " + lastError );
+    }
+}
+
+} // namespace
+
+
+
 Database& operator>>(
     Database& store,
     Object& doc
@@ -20,6 +216,7 @@ Database& operator>>(
         const Document d = store.getDocument( uid );
         const auto& t = d.getData();
         doc = boost::any_cast< Object >( *t );
+        store.remember( doc );
 
     } catch ( ... ) {
         //   ,  
@@ -36,6 +233,8 @@ Database& operator>>(
     Database& store,
     Mode::Doc& doc
 ) {
+    Communication::DeadlineScope deadline( store.getCommunication(), doc.deadline );
+
     //   CouchDB      UID
     // @see http://wiki.apache.org/couchdb/HTTP_view_API#Querying_Options / keys
 
@@ -58,6 +257,16 @@ Database& operator>>(
         doc.totalRows = static_cast< size_t >( o["total_rows"] );
         //  - ,       'keys'
         doc.result = static_cast< Array >( o["rows"] );
+        // @see Database::trackDigests()
+        if ( store.tracksDigests() ) {
+            for (auto itr = doc.result.cbegin(); itr != doc.result.cend(); ++itr) {
+                const Object& row = boost::any_cast< const Object& >( **itr );
+                const auto dtr = row.find( "doc" );
+                if ( (dtr != row.cend()) && dtr->second && (dtr->second->type() == typeid( Object )) ) {
+                    store.remember( boost::any_cast< const Object& >( *dtr->second ) );
+                }
+            }
+        }
 
     } catch ( const Exception& ex ) {
         //      
@@ -79,6 +288,8 @@ Database& operator>>(
     Database& store,
     Mode::View& view
 ) {
+    Communication::DeadlineScope deadline( store.getCommunication(), view.deadline );
+
     /* - @todo       http://wiki.apache.org/couchdb/HTTP_view_API?action=show&redirect=HttpViewApi#Querying_Options
     //     
     std::string key = "";
@@ -96,6 +307,10 @@ Database& operator>>(
     if (view.limit > 0) {
         key += "&limit=" + boost::lexical_cast< std::string >( view.limit );
     }
+    // (!)  'stale',   'view.key',  
+    if ( (view.freshness != Mode::View::FRESH) && (view.key.find( "stale=" ) == std::string::npos) ) {
+        key += (view.freshness == Mode::View::STALE_OK) ? "&stale=ok" : "&stale=update_after";
+    }
     if (key[0] == '&') {
         key = key.substr( 1 );
     }
@@ -125,14 +340,56 @@ Database& operator>>(
 
 
 
+Database& operator>>(
+    Database& store,
+    Mode::Find& find
+) {
+    Communication::DeadlineScope deadline( store.getCommunication(), find.deadline );
+
+    //  
+    find.ok = true;
+    try {
+        Object o = store.find( find.json() );
+        find.result = static_cast< Array >( o[ "docs" ] );
+        const auto ftr = o.find( "bookmark" );
+        if (ftr != o.cend()) {
+            find.bookmark = boost::any_cast< std::string >( *ftr->second );
+            //      'bookmark'
+            find.skip = 0;
+        }
+        const auto ftw = o.find( "warning" );
+        find.warning = (ftw == o.cend())
+            ? "" : boost::any_cast< std::string >( *ftw->second );
+
+    } catch ( const Exception& ex ) {
+        //      
+        find.result = Array();
+        find.warning = "";
+        find.ok = false;
+        find.exception = std::shared_ptr< Exception >( new Exception( ex ) );
+    }
+
+    return store;
+}
+
+
+
+
+
+
 Database& operator<<(
     Database& store,
     Mode::NewOnly& doc
 ) {
-    // 'doc'     Object   Pool
-    assert( doc.p || doc.o );
+    Communication::DeadlineScope deadline( store.getCommunication(), doc.deadline );
 
-    if ( doc.p ) {
+    // 'doc'     Object, Pool  DocPool
+    assert( doc.p || doc.dp || doc.o );
+
+    if ( doc.dp ) {
+        store.createBulk( *doc.dp, doc.fnCreateJSON );
+
+    } else if ( doc.p ) {
         const Array a = (Array)( *doc.p );
         store.createBulk( a, doc.fnCreateJSON );
 
@@ -152,23 +409,32 @@ Database& operator<<(
     Database& store,
     Mode::NewSkip& doc
 ) {
+    Communication::DeadlineScope deadline( store.getCommunication(), doc.deadline );
+
     // @info  NewUpdate,     
 
-    // 'doc'     Object   Pool
-    assert( doc.p || doc.o );
+    // 'doc'     Object, Pool  DocPool
+    assert( doc.p || doc.dp || doc.o );
 
-    if ( doc.p ) {
+    //  :    " "
+    //   
+    // @todo fine    ?
+    if ( doc.dp ) {
+        store.createBulk( *doc.dp, doc.fnCreateJSON );
+
+    } else if ( doc.p ) {
         //  , .    - 
         const Array a = (Array)( *doc.p );
         const Array r = store.createBulk( a, doc.fnCreateJSON );
-        //  :    " "
-        //   
-        // @todo fine    ?
 
     } else {
         //     -  
+        /* - Pool  Object*,   Object. . . .
         Pool singleRepush;
         singleRepush.push_back( typelib::json::cjv( *doc.o ) );
+        */
+        DocPool singleRepush;
+        singleRepush.borrow( *doc.o );
         store << Mode::NewSkip( singleRepush, doc.fnCreateJSON );
 
     } // else if ( doc.p )
@@ -181,6 +447,115 @@ Database& operator<<(
 
 
 
+Database& operator<<(
+    Database& store,
+    Mode::NewSkipMany& doc
+) {
+    Communication::DeadlineScope deadline( store.getCommunication(), doc.deadline );
+
+    // 'doc'     Object   Pool
+    assert( doc.p || doc.o );
+
+    Pool single;
+    if ( doc.o ) {
+        single.push_back( typelib::json::cjv( doc.o ) );
+    }
+    const Array& a = doc.p ? static_cast< const Array& >( *doc.p ) : single;
+
+    //   UID -  ; UID,   , - 
+    Pool fresh;
+    // ,  : (UID, )
+    std::vector< std::pair< uid_t, Variant > >  maybe;
+    for (auto itr = a.cbegin(); itr != a.cend(); ++itr) {
+        const Object* o = boost::any_cast< Object* >( **itr );
+        const uid_t id = hasUID( *o ) ? uid( *o ) : "";
+        if ( id.empty() || !doc.seen.mayContain( id ) ) {
+            fresh.push_back( *itr );
+        } else if ( doc.verify ) {
+            maybe.push_back( std::make_pair( id, *itr ) );
+        }
+    }
+
+    //     
+    if ( !maybe.empty() ) {
+        std::vector< uid_t >  keys;
+        for (auto itr = maybe.cbegin(); itr != maybe.cend(); ++itr) {
+            keys.push_back( itr->first );
+        }
+        std::ostringstream ss;
+        ss << "{\"keys\":";
+            typelib::print( ss, keys, "[", "]", "\"", "," );
+        ss << "}";
+        const Variant var = store.getCommunication().getData(
+            "/" + store.getName() + "/_all_docs", "POST", ss.str()
+        );
+        if ( hasError( var ) ) {
+            throw Exception( "Unrecognized exception: " + error( var ) );
+        }
+        Object o = boost::any_cast< Object >( *var );
+        const Array rows = static_cast< Array >( o[ "rows" ] );
+        for (size_t i = 0; i < maybe.size(); ++i) {
+            const Object row = boost::any_cast< Object >( *rows.at( i ) );
+            const auto value = row.find( "value" );
+            const bool exists = !hasError( row ) && (value != row.cend())
+                && (boost::any_cast< Object >( *value->second ).count( "deleted" ) == 0);
+            if ( !exists ) {
+                fresh.push_back( maybe[ i ].second );
+            }
+        }
+    }
+
+    if ( fresh.empty() ) {
+        return store;
+    }
+
+    //  ,  NewSkip.    (,
+    // ) UID .
+    const Array r = store.createBulk( fresh, doc.fnCreateJSON );
+    for (auto itr = r.cbegin(); itr != r.cend(); ++itr) {
+        const Object& ro = boost::any_cast< const Object& >( **itr );
+        const auto ftr = ro.find( "id" );
+        if (ftr != ro.cend()) {
+            doc.seen.add( boost::any_cast< std::string >( *ftr->second ) );
+        }
+    }
+
+    return store;
+}
+
+
+
+
+
+
+Database& operator<<(
+    Database& store,
+    Mode::AppendNewOnly& doc
+) {
+    Communication::DeadlineScope deadline( store.getCommunication(), doc.deadline );
+    append( store, doc, false );
+    return store;
+}
+
+
+
+
+
+
+Database& operator<<(
+    Database& store,
+    Mode::AppendUpdate& doc
+) {
+    Communication::DeadlineScope deadline( store.getCommunication(), doc.deadline );
+    append( store, doc, true );
+    return store;
+}
+
+
+
+
+
+
 Database& operator<<(
     Database& store,
     Mode::File& file
@@ -211,48 +586,45 @@ Database& operator<<(
     Database& store,
     Mode::NewUpdate& doc
 ) {
-    assert( (doc.p || doc.o)
-        && "'doc'      Object,   Pool." );
+    Communication::DeadlineScope deadline( store.getCommunication(), doc.deadline );
 
-    if ( doc.p ) {
-        // *Pool*
+    assert( (doc.p || doc.dp || doc.o)
+        && "'doc'     Object, Pool  DocPool." );
+
+    if ( doc.dp ) {
+        // *DocPool*
         //    -
         //  ; .    - 
-        Array& a = static_cast< Array& >( *doc.p );
-        // #! @todo   ?
-        //    1. doc    const.
-        //    2. doc    typelib::json::variant.
-        const Array result = store.createBulk( a, doc.fnCreateJSON );
-        //  ,  UID  REV,  
-        //     
-        Pool repush;
+        // ,    ,  
+        // @see Database::trackDigests()
+        DocPool changed;
+        if ( store.tracksDigests() ) {
+            changed.reserve( doc.dp->size() );
+            for (size_t i = 0; i < doc.dp->size(); ++i) {
+                Object& obj = ( *doc.dp )[ i ];
+                const rev_t& rev = store.unchanged( obj );
+                if ( rev.empty() ) {
+                    changed.borrow( obj );
+                    continue;
+                }
+                revision( obj, rev );
+                doc.skipped.push_back( CouchFine::uid( obj ) );
+            }
+            if ( changed.empty() ) {
+                return store;
+            }
+        }
+        DocPool& pool = store.tracksDigests() ? changed : *doc.dp;
+
+        //    UID    createBulk()
+        const Array result = store.createBulk( pool, doc.fnCreateJSON );
+        //  ,     
+        //  .   : 'repush' 
+        //    'pool'.
+        DocPool repush;
         for (auto rtr = result.cbegin(); rtr != result.cend(); ++rtr) {
-            //const auto& type = itr->get()->type();
-
-            //  createBulk()   .   
-            const auto i = std::distance( result.cbegin(), rtr );
-            auto& objAny = *a.at( i );
-#ifdef _DEBUG
-            const std::string& typeName = objAny.type().name();
-#endif
-            /* -  Pool      std::shared_ptr.
-            Object* obj =
-                (objAny.type() == typeid( std::shared_ptr< Object > ))
-                ? boost::any_cast< std::shared_ptr< Object > >( objAny ).get()
-                : boost::any_cast< Object* >( objAny );
-            */
-            assert( (objAny.type() == typeid( Object* ))
-                && " Object    .    .   std::shared_ptr   Object  Pool." );
-            Object* obj = boost::any_cast< Object* >( objAny );
-
             const Object& ro = boost::any_cast< Object >( **rtr );
             if ( !hasError( ro ) ) {
-                //    UID  
-                const uid_t& uid = CouchFine::uid( ro );
-                const rev_t& rev = revision( ro );
-                CouchFine::uid( *obj, uid, rev );
-                // 'obj', ,      'doc.p'
-                //a.at( i ) = typelib::json::cjv( obj );
                 // @todo fine       ? 
                 //             .
                 continue;
@@ -263,8 +635,12 @@ Database& operator<<(
             std::cerr << error( ro ) << std::endl;
 #endif
 
+            //  createBulk()   .   
+            const auto i = std::distance( result.cbegin(), rtr );
+            Object& obj = pool[ i ];
+
             //    
-            const auto uid = CouchFine::uid( *obj );
+            const auto uid = CouchFine::uid( obj );
             assert( !uid.empty()
                 && "   UID     ." );
             Object sObj;
@@ -277,37 +653,52 @@ Database& operator<<(
 
             // .    'doc' UID   ,  
             const rev_t& rev = revision( sObj );
-            revision( *obj, rev );
-            repush << obj;
+            revision( obj, rev );
+            repush.borrow( obj );
 
-        } // for (auto itr = r.cbegin(); itr != r.cend(); ++itr)
+        } // for (auto rtr = result.cbegin(); rtr != result.cend(); ++rtr)
 
         //   ()
         if ( !repush.empty() ) {
-            store << Mode::NewUpdate( repush, doc.fnCreateJSON );
+            Mode::NewUpdate again( repush, doc.fnCreateJSON );
+            store << again;
+            doc.skipped.insert( doc.skipped.end(), again.skipped.cbegin(), again.skipped.cend() );
             // @todo fine   .
         }
 
+    } else if ( doc.p ) {
+        // *Pool*
+        //    :   ,  
+        DocPool pool( doc.p->size() );
+        for (auto itr = doc.p->cbegin(); itr != doc.p->cend(); ++itr) {
+            const auto& objAny = **itr;
+            /* -  Pool      std::shared_ptr.
+            Object* obj =
+                (objAny.type() == typeid( std::shared_ptr< Object > ))
+                ? boost::any_cast< std::shared_ptr< Object > >( objAny ).get()
+                : boost::any_cast< Object* >( objAny );
+            */
+            assert( (objAny.type() == typeid( Object* ))
+                && " Object    .    .   std::shared_ptr   Object  Pool." );
+            pool.borrow( *boost::any_cast< Object* >( objAny ) );
+        }
+        Mode::NewUpdate repush( pool, doc.fnCreateJSON );
+        store << repush;
+        doc.skipped = repush.skipped;
+
     } else {
         // *Object*
-        //     -  ...
+        //     -  .  
+        // UID  :    .
+        /* - Pool  Object*,   Object. . . .
         Pool singleRepush;
         singleRepush.push_back( typelib::json::cjv( *doc.o ) );
-        store << Mode::NewUpdate( singleRepush, doc.fnCreateJSON );
-
-        // ... :   
-            const auto& objAny = *singleRepush.front();
-            const Object& ro = boost::any_cast< Object >( objAny );
-            if ( hasError( ro ) ) {
-                std::cerr << "operator<<( Database, NewUpdate ) " << error( ro ) << std::endl;
-                throw Exception( "Unrecognized exception: " + error( ro ) );
-            }
-            //    UID  
-            const uid_t& uid = CouchFine::uid( ro );
-            const rev_t& rev = revision( ro );
-            CouchFine::uid( *doc.o, uid, rev );
-            // @todo fine       ? 
-            //             .
+        */
+        DocPool singlePool;
+        singlePool.borrow( *doc.o );
+        Mode::NewUpdate singleRepush( singlePool, doc.fnCreateJSON );
+        store << singleRepush;
+        doc.skipped = singleRepush.skipped;
 
     } // else if ( doc.p )
 
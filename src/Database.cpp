@@ -2,6 +2,9 @@
 #include "../include/Database.h"
 #include "../include/Exception.h"
 #include <typelib/typelib.h>
+#include <cctype>
+#include <set>
+#include <boost/thread.hpp>
 
 
 using namespace CouchFine;
@@ -19,9 +22,328 @@ static std::string createJSON( const Variant &data ) {
 
 
 
+
+namespace {
+
+/**
+* @return    JSON,    .
+*/
+std::string encodeKey( const std::string& json ) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string r;
+    r.reserve( json.size() * 3 );
+    for (auto itr = json.cbegin(); itr != json.cend(); ++itr) {
+        const unsigned char c = static_cast< unsigned char >( *itr );
+        if ( std::isalnum( c ) || (c == '-') || (c == '.') || (c == '_') || (c == '~') ) {
+            r += static_cast< char >( c );
+        } else {
+            r += '%';
+            r += HEX[ c >> 4 ];
+            r += HEX[ c & 0x0F ];
+        }
+    }
+    return r;
+}
+
+
+
+
+/**
+*  , . Database::scan().
+*/
+struct Partition {
+    //   : startkey, startkey_docid, skip
+    std::string next;
+    //  : endkey, inclusive_end
+    std::string end;
+    bool done;
+    // ,      ( Scan::ordered)
+    std::deque< Array >  pages;
+
+    inline Partition() : done( false ) {
+    }
+};
+
+
+
+
+/**
+*      , . Database::sampleBounds().
+*/
+struct Probe {
+    Variant key;
+    //    JSON ( )
+    std::string json;
+    // -    
+    size_t rank;
+    //    
+    bool bound;
+
+    inline Probe(
+        const Variant& key,
+        size_t rank,
+        bool bound,
+        const std::string& json = ""
+    ) : key( key ), json( json ), rank( rank ), bound( bound ) {
+    }
+};
+
+
+
+
+/**
+* @return false,   -  .
+*/
+bool number( const Variant& var, double& r ) {
+    if ( !var ) {
+        return false;
+    }
+    const type_info& type = var->type();
+    if (type == typeid( int )) {
+        r = boost::any_cast< int >( *var );
+    } else if (type == typeid( size_t )) {
+        r = static_cast< double >( boost::any_cast< size_t >( *var ) );
+    } else if (type == typeid( long )) {
+        r = boost::any_cast< long >( *var );
+    } else if (type == typeid( float )) {
+        r = boost::any_cast< float >( *var );
+    } else if (type == typeid( double )) {
+        r = boost::any_cast< double >( *var );
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+
+
+/**
+* @return   UTF-8.    UTF-8 -  .
+*/
+std::vector< boost::uint32_t >  codePoints( const std::string& s ) {
+    std::vector< boost::uint32_t >  r;
+    for (size_t i = 0; i < s.size(); ) {
+        const unsigned char c = static_cast< unsigned char >( s[ i ] );
+        const size_t n = (c < 0x80) ? 1 : ((c >> 5) == 0x06) ? 2 : ((c >> 4) == 0x0E) ? 3 : 0;
+        if ( (n == 0) || (i + n > s.size()) ) {
+            r.clear();
+            for (auto itr = s.cbegin(); itr != s.cend(); ++itr) {
+                r.push_back( static_cast< unsigned char >( *itr ) );
+            }
+            return r;
+        }
+        boost::uint32_t cp = (n == 1) ? c : (n == 2) ? (c & 0x1F) : (c & 0x0F);
+        for (size_t k = 1; k < n; ++k) {
+            cp = (cp << 6) | (static_cast< unsigned char >( s[ i + k ] ) & 0x3F);
+        }
+        r.push_back( cp );
+        i += n;
+    }
+    return r;
+}
+
+
+
+
+/**
+* @return  JSON    'lo'  'hi':   ,
+*           - .    - ,
+*          -     (   '0'-'9'):
+*             .
+*         (!)    CouchDB (ICU)     ,
+*             :     .
+*/
+std::string middleString( const std::string& lo, const std::string& hi ) {
+    const std::vector< boost::uint32_t >  a = codePoints( lo );
+    const std::vector< boost::uint32_t >  b = codePoints( hi );
+    size_t first = 0;
+    while ( (first < a.size()) && (first < b.size()) && (a[ first ] == b[ first ]) ) {
+        ++first;
+    }
+    boost::uint32_t tmin = '0';
+    boost::uint32_t tmax = '9';
+    for (size_t i = first + 1; i < a.size(); ++i) {
+        tmin = std::min( tmin, a[ i ] );
+        tmax = std::max( tmax, a[ i ] );
+    }
+    for (size_t i = first + 1; i < b.size(); ++i) {
+        tmin = std::min( tmin, b[ i ] );
+        tmax = std::max( tmax, b[ i ] );
+    }
+    tmin = std::max< boost::uint32_t >( tmin, 0x20 );
+    tmax = std::min< boost::uint32_t >( tmax, 0xFFFF );
+    const auto low = [ first, tmin ] ( size_t i ) -> boost::uint32_t {
+        return (i > first) ? tmin : 0;
+    };
+    const auto base = [ first, tmin, tmax ] ( size_t i ) -> boost::uint32_t {
+        return (i > first) ? (tmax - tmin + 1) : 0x10000;
+    };
+    const auto digit = [ &low, &base ] ( const std::vector< boost::uint32_t >& s, size_t i ) -> boost::uint32_t {
+        return (i < s.size())
+            ? std::min( std::max( s[ i ], low( i ) ) - low( i ), base( i ) - 1 ) : 0;
+    };
+
+    //   -  ,      1
+    const size_t n = std::max( a.size(), b.size() ) + 1;
+    std::vector< boost::uint32_t >  sum( n + 1, 0 );
+    for (size_t i = n; i > 0; --i) {
+        sum[ i ] += digit( a, i - 1 ) + digit( b, i - 1 );
+        sum[ i - 1 ] += sum[ i ] / base( i - 1 );
+        sum[ i ] %= base( i - 1 );
+    }
+    std::vector< boost::uint32_t >  mid( n );
+    boost::uint32_t rest = sum[ 0 ];
+    for (size_t i = 0; i < n; ++i) {
+        const boost::uint32_t d = rest * base( i ) + sum[ i + 1 ];
+        mid[ i ] = d / 2 + low( i );
+        rest = d % 2;
+    }
+    while ( (mid.size() > first + 1) && (mid.back() == low( mid.size() - 1 )) ) {
+        mid.pop_back();
+    }
+
+    std::string r = "\"";
+    for (auto itr = mid.cbegin(); itr != mid.cend(); ++itr) {
+        boost::uint32_t cp = *itr;
+        //  , , '\\'    
+        if (cp < 0x20) {
+            cp = 0x20;
+        } else if ( (cp == '"') || (cp == '\\') ) {
+            ++cp;
+        } else if ( (cp >= 0xD800) && (cp < 0xE000) ) {
+            cp = 0xE000;
+        }
+        if (cp < 0x80) {
+            r += static_cast< char >( cp );
+        } else if (cp < 0x800) {
+            r += static_cast< char >( 0xC0 | (cp >> 6) );
+            r += static_cast< char >( 0x80 | (cp & 0x3F) );
+        } else {
+            r += static_cast< char >( 0xE0 | (cp >> 12) );
+            r += static_cast< char >( 0x80 | ((cp >> 6) & 0x3F) );
+            r += static_cast< char >( 0x80 | (cp & 0x3F) );
+        }
+    }
+    r += '"';
+    return r;
+}
+
+
+
+
+/**
+* @return  JSON   'lo' < 'hi':  , 
+*          ;   -    .
+*          -     :  .
+*/
+std::string middleKey( const Variant& lo, const Variant& hi ) {
+    double x = 0, y = 0;
+    if ( number( lo, x ) && number( hi, y ) ) {
+        std::ostringstream ostr;
+        printDouble( ostr, (x + y) / 2 );
+        return ostr.str();
+    }
+    if ( !lo || !hi || (lo->type() != hi->type()) ) {
+        return "";
+    }
+    if (lo->type() == typeid( std::string )) {
+        return middleString( boost::any_cast< const std::string& >( *lo ), boost::any_cast< const std::string& >( *hi ) );
+    }
+    if (lo->type() == typeid( Array )) {
+        const Array& a = boost::any_cast< const Array& >( *lo );
+        const Array& b = boost::any_cast< const Array& >( *hi );
+        std::string prefix = "[";
+        for (size_t i = 0; (i < a.size()) && (i < b.size()); ++i) {
+            const std::string e = createJSON( a[ i ] );
+            if (e != createJSON( b[ i ] )) {
+                const std::string m = middleKey( a[ i ], b[ i ] );
+                return m.empty() ? "" : prefix + m + "]";
+            }
+            prefix += e + ",";
+        }
+    }
+    return "";
+}
+
+
+
+
+/**
+* @return   : FNV-1a    JSON  _rev
+*            ,  _id  _deleted.  
+*          Object -  ,  .
+*         0 -    (  Mode::File::PREFIX()).
+*/
+boost::uint64_t digest( const Object& doc ) {
+    std::ostringstream out;
+    for (auto dtr = doc.cbegin(); dtr != doc.cend(); ++dtr) {
+        const std::string& field = dtr->first;
+        if ( boost::starts_with( field, Mode::File::PREFIX() ) ) {
+            return 0;
+        }
+        if ( boost::starts_with( field, "_" ) && (field != "_id") && (field != "_deleted") ) {
+            continue;
+        }
+        out << '"' << field << "\":";
+        printHelper( out, *dtr->second, "" );
+        out << ',';
+    }
+
+    const std::string& s = out.str();
+    boost::uint64_t h = 14695981039346656037ULL;
+    for (auto itr = s.cbegin(); itr != s.cend(); ++itr) {
+        h ^= static_cast< unsigned char >( *itr );
+        h *= 1099511628211ULL;
+    }
+    return (h == 0) ? 1 : h;
+}
+
+
+
+
+/**
+*       _bulk_docs.  Mode::File::PREFIX()
+* .
+*/
+void writeBulkDoc( std::ostream& out, const Object& doc ) {
+    out << "{";
+    bool addComma = false;
+    for (auto dtr = doc.cbegin(); dtr != doc.cend(); ++dtr) {
+        const std::string& field = dtr->first;
+        if ( boost::starts_with( field, Mode::File::PREFIX() ) ) {
+            continue;
+        }
+        if ( addComma ) {
+            out << ", ";
+        } else {
+            addComma = true;
+        }
+        out << '"' << field << "\": ";
+        printHelper( out, *dtr->second, "" );
+    }
+    out << "}";
+}
+
+} // namespace
+
+
+
+
+/**
+* UID -> ( , ).
+*/
+struct Database::Digests {
+    boost::mutex mutex;
+    std::map< uid_t, std::pair< boost::uint64_t, rev_t > >  known;
+};
+
+
+
 Database::Database(Communication &_comm, const std::string& _name)
    : comm(_comm)
    , name(_name)
+   , accCoalesce(false)
 {
 }
 
@@ -30,6 +352,10 @@ Database::Database(Communication &_comm, const std::string& _name)
 Database::Database(const Database &db)
    : comm(db.comm)
    , name(db.name)
+   , digests(db.digests)
+   , viewCache(db.viewCache)
+   , accCoalesce(db.accCoalesce)
+   , accMerge(db.accMerge)
 {
 }
 
@@ -126,6 +452,131 @@ Document Database::getDocument( const uid_t& id, const rev_t& rev ) {
 
 
 
+CouchFine::Array Database::bulkGet(
+    const std::vector< uidrev_t >&  docs,
+    bool revs,
+    size_t batchSize,
+    size_t concurrency
+) {
+    assert( (batchSize > 0) && "     0." );
+
+    Array result( docs.size() );
+    if ( docs.empty() ) {
+        return result;
+    }
+    const auto fail = [ &result, &docs ] ( size_t i, const Object& e ) {
+        Object o = e;
+        o[ "id" ] = typelib::json::cjv( docs[ i ].first );
+        o[ "rev" ] = typelib::json::cjv( docs[ i ].second );
+        result[ i ] = typelib::json::cjv( o );
+    };
+
+    //  - 
+    std::vector< Communication::Request >  requests;
+    for (size_t begin = 0; begin < docs.size(); begin += batchSize) {
+        const size_t end = std::min( begin + batchSize, docs.size() );
+        Array a;
+        for (size_t i = begin; i < end; ++i) {
+            Object d;
+            d[ "id" ] = typelib::json::cjv( docs[ i ].first );
+            if ( !docs[ i ].second.empty() ) {
+                d[ "rev" ] = typelib::json::cjv( docs[ i ].second );
+            }
+            a.push_back( typelib::json::cjv( d ) );
+        }
+        Object o;
+        o[ "docs" ] = typelib::json::cjv( a );
+        requests.push_back( Communication::Request(
+            "/" + name + "/_bulk_get" + ( revs ? "?revs=true" : "" ),
+            "POST", createJSON( typelib::json::cjv( o ) )
+        ) );
+    }
+    const std::vector< Variant >  responses = comm.getDataBatch( requests, concurrency );
+
+    Object malformed;
+    malformed[ "error" ] = typelib::json::cjv( std::string( "bad_response" ) );
+    malformed[ "reason" ] = typelib::json::cjv( std::string( "Unexpected _bulk_get response." ) );
+
+    //  ,   
+    std::vector< size_t >  single;
+    for (size_t k = 0; k < responses.size(); ++k) {
+        const size_t begin = k * batchSize;
+        const size_t end = std::min( begin + batchSize, docs.size() );
+        const Variant& var = responses[ k ];
+        if ( !var || (var->type() != typeid( Object )) ) {
+            for (size_t i = begin; i < end; ++i) {
+                fail( i, malformed );
+            }
+            continue;
+        }
+        Object o = boost::any_cast< Object >( *var );
+        if ( hasError( o ) ) {
+            //  _bulk_get (CouchDB 1.x): 404  405.  
+            // (, )    .
+            const std::string e = v< std::string >( o, "error" );
+            const bool unsupported = (e == "not_found") || (e == "method_not_allowed");
+            for (size_t i = begin; i < end; ++i) {
+                if ( unsupported ) {
+                    single.push_back( i );
+                } else {
+                    fail( i, o );
+                }
+            }
+            continue;
+        }
+
+        //     ,    
+        const auto rtr = o.find( "results" );
+        const Array results = ( (rtr != o.cend()) && rtr->second && (rtr->second->type() == typeid( Array )) )
+            ? boost::any_cast< Array >( *rtr->second ) : Array();
+        for (size_t i = begin; i < end; ++i) {
+            try {
+                const Object r = boost::any_cast< Object >( *results.at( i - begin ) );
+                const Array found = boost::any_cast< Array >( *r.at( "docs" ) );
+                const Object d = boost::any_cast< Object >( *found.at( 0 ) );
+                const auto ftr = d.find( "ok" );
+                if (ftr != d.cend()) {
+                    result[ i ] = ftr->second;
+                } else {
+                    fail( i, boost::any_cast< Object >( *d.at( "error" ) ) );
+                }
+            } catch ( const std::exception& ) {
+                //       
+                fail( i, malformed );
+            }
+        }
+    }
+
+    //  _bulk_get:    
+    if ( !single.empty() ) {
+        requests.clear();
+        for (auto itr = single.cbegin(); itr != single.cend(); ++itr) {
+            const uidrev_t& d = docs[ *itr ];
+            std::string url = "/" + name + "/" + d.first;
+            std::string query = d.second.empty() ? "" : ("rev=" + d.second);
+            if ( revs ) {
+                query += std::string( query.empty() ? "" : "&" ) + "revs=true";
+            }
+            requests.push_back( Communication::Request( url + ( query.empty() ? "" : ("?" + query) ) ) );
+        }
+        //  :  -   getDataBatch()
+        const std::vector< Variant >  responses = comm.getDataBatch( requests );
+        for (size_t k = 0; k < responses.size(); ++k) {
+            const Object o = boost::any_cast< Object >( *responses[ k ] );
+            if ( hasError( o ) ) {
+                fail( single[ k ], o );
+            } else {
+                result[ single[ k ] ] = responses[ k ];
+            }
+        }
+    }
+
+    return result;
+}
+
+
+
+
 CouchFine::Object Database::getView(
     const std::string& viewName,
     const std::string& designName,
@@ -171,6 +622,38 @@ CouchFine::Object Database::getView(
 #endif
 
 
+    //      ETag:  
+    //  304  
+    // @see setViewCache()
+    if ( viewCache ) {
+        Communication& c = comm;
+        const std::string cacheKey = "/" + name + "/" + designUID + "/_view/" + viewName
+            + "?" + ViewCache::normalizeQuery( key );
+        return viewCache->get( cacheKey, [ &c, &url, &viewName ] (
+            const std::string& etag,
+            std::string& newETag,
+            Object& result
+        ) -> bool {
+            Communication::HeaderMap headers;
+            headers[ "Accept" ] = "application/json";
+            if ( !etag.empty() ) {
+                headers[ "If-None-Match" ] = etag;
+            }
+            const std::string body = c.getRawData( url, headers );
+            if (c.responseStatus() == 304) {
+                return false;
+            }
+            const Variant var = Communication::parseData( body );
+            result = boost::any_cast< Object >( *var );
+            if ( hasError( result ) ) {
+                throw Exception( "View '" + viewName + "': " + error( result ) );
+            }
+            const auto htr = c.responseHeaders().find( "etag" );
+            newETag = (htr != c.responseHeaders().cend()) ? htr->second : "";
+            return true;
+        }, comm.deadline() );
+    }
+
     const Variant var = comm.getData( url );
     const Object obj = boost::any_cast< Object >( *var );
     if ( hasError( obj ) ) {
@@ -275,14 +758,22 @@ Document Database::createDocument( const std::string& json, const std::string& i
 
 
 
-CouchFine::Array Database::createBulk(
+std::string Database::prepareBulk(
     const CouchFine::Array&    docs,
     CouchFine::fnCreateJSON_t  fnCreateJSON
 ) {
-    // I.  .
+    //  'fnCreateJSON'   ,  
+    if ( !fnCreateJSON ) {
+        DocPool pool( docs.size() );
+        for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+            // #! ? ,     const-.
+            pool << boost::any_cast< Object* >( **itr );
+        }
+        return prepareBulk( pool );
+    }
 
     //     ,   Mode::File::PREFIX
-    // @todo optimize   'docs'.  .
+    // 'fnCreateJSON'   :   'docs'.
     Array preparedDocs;
     for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
 #ifdef _DEBUG
@@ -314,6 +805,21 @@ CouchFine::Array Database::createBulk(
         ? ( fnCreateJSON )( typelib::json::cjv( o ) )
         : createJSON( typelib::json::cjv( o ) );
 
+    return json;
+}
+
+
+
+
+
+
+CouchFine::Array Database::createBulk(
+    const CouchFine::Array&    docs,
+    CouchFine::fnCreateJSON_t  fnCreateJSON
+) {
+    // I.  .
+    const std::string json = prepareBulk( docs, fnCreateJSON );
+
     // @see http://wiki.apache.org/couchdb/HTTP_Bulk_Document_API#Modify_Multiple_Documents_With_a_Single_Request
     assert( !name.empty()
         && "Store is don't initialized." );
@@ -328,47 +834,95 @@ CouchFine::Array Database::createBulk(
 
 
     // II.  -.
-    // @todo     ,   plain/text.
     // @todo optimize        .
+    // @see saveFiles()
     for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
         const Object* d = boost::any_cast< Object* >( **itr );
-        for (auto dtr = d->cbegin(); dtr != d->cend(); ++dtr) {
-            const std::string& field = dtr->first;
-            if ( boost::starts_with( field, Mode::File::PREFIX() ) ) {
-                //   - 
-                //      ,  -  
-                // -    -  'docs'
-                const std::size_t i = std::distance( docs.cbegin(), itr );
-                const Object& ora = boost::any_cast< Object& >( *ra.at( i ) );
-                const std::string nameFile =
-                    boost::erase_first_copy( field, Mode::File::PREFIX() );
-                const std::string& dataFile = boost::any_cast< std::string& >( *dtr->second );
-                const uid_t& uidDoc = uid( ora );
-                assert( !uidDoc.empty() && "  UID. ..." );
-                const rev_t& revisionDoc = revision( ora );
-                assert( !revisionDoc.empty() && "  . ..." );
-                /* - . . .
-                *this << Mode::File( name, data, uidDoc, revisionDoc );
-                */
-                /* -   ,     . . .
-                Document doc = getDocument( uidDoc );
-                */
-                Document doc(
-                    Database::comm, Database::name,
-                    uidDoc, "", revisionDoc
-                );
-                const bool result = doc.addAttachment( nameFile, "text/plain", dataFile );
-                if ( !result ) {
-                    throw CouchFine::Exception( "Could not create attachment '" + nameFile + "' with data '" + dataFile + "'." );
+        //   - 
+        const std::size_t i = std::distance( docs.cbegin(), itr );
+        saveFiles( *d, boost::any_cast< Object& >( *ra.at( i ) ) );
+    }
+
+
+    return ra;
+}
+
+
+
+
+
+std::string Database::prepareBulk(
+    const CouchFine::DocPool&  docs,
+    CouchFine::fnCreateJSON_t  fnCreateJSON
+) {
+    if ( fnCreateJSON ) {
+        // 'fnCreateJSON'     Variant:   
+        // Mode::File::PREFIX
+        Array preparedDocs;
+        for (size_t i = 0; i < docs.size(); ++i) {
+            Object obj;
+            const Object& d = docs[ i ];
+            for (auto dtr = d.cbegin(); dtr != d.cend(); ++dtr) {
+                if ( !boost::starts_with( dtr->first, Mode::File::PREFIX() ) ) {
+                    obj.insert( obj.end(), *dtr );
                 }
+            }
+            preparedDocs.push_back( typelib::json::cjv( obj ) );
+        }
+        Object o;
+        o["docs"] = typelib::json::cjv( preparedDocs );
+        return ( fnCreateJSON )( typelib::json::cjv( o ) );
+    }
+
+    // @see http://wiki.apache.org/couchdb/HTTP_Bulk_Document_API#Modify_Multiple_Documents_With_a_Single_Request
+    std::ostringstream out;
+    out << "{\"docs\": [";
+    for (size_t i = 0; i < docs.size(); ++i) {
+        if (i > 0) {
+            out << ", ";
+        }
+        writeBulkDoc( out, docs[ i ] );
+    }
+    out << "]}";
+
+    return out.str();
+}
 
-            } // if ( boost::starts_with( field, Mode::File::PREFIX() ) )
 
-        } // for (auto dtr = d.cbegin(); dtr != d.cend(); ++dtr)
 
-    } // for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr)
 
 
+CouchFine::Array Database::createBulk(
+    CouchFine::DocPool&        docs,
+    CouchFine::fnCreateJSON_t  fnCreateJSON
+) {
+    // I.  .
+    const std::string json = prepareBulk( docs, fnCreateJSON );
+
+    assert( !name.empty()
+        && "Store is don't initialized." );
+    const Variant var = comm.getData( "/" + name + "/_bulk_docs",  "POST",  json );
+    if ( hasError( var ) ) {
+        std::cerr << "JSON: " << json << std::endl;
+        std::cerr << "CouchFine::createBulk( DocPool& ) " << error( var ) << std::endl;
+        throw CouchFine::Exception( "Unrecognized exception: " + error( var ) );
+    }
+
+    const Array ra = boost::any_cast< Array >( *var );
+
+    // II.   UID  ,  -.
+    //      .
+    for (size_t i = 0; (i < docs.size()) && (i < ra.size()); ++i) {
+        const Object& ora = boost::any_cast< Object& >( *ra[ i ] );
+        if ( hasError( ora ) ) {
+            continue;
+        }
+        Object& d = docs[ i ];
+        CouchFine::uid( d, uid( ora ), revision( ora ) );
+        saveFiles( d, ora );
+        remember( d );
+    }
+
     return ra;
 }
 
@@ -376,10 +930,38 @@ CouchFine::Array Database::createBulk(
 
 
 
+void Database::saveFiles( const Object& d, const Object& ora ) {
+    // @todo     ,   plain/text.
+    for (auto dtr = d.cbegin(); dtr != d.cend(); ++dtr) {
+        const std::string& field = dtr->first;
+        if ( !boost::starts_with( field, Mode::File::PREFIX() ) ) {
+            continue;
+        }
+        const std::string nameFile =
+            boost::erase_first_copy( field, Mode::File::PREFIX() );
+        const std::string& dataFile = boost::any_cast< std::string& >( *dtr->second );
+        const uid_t& uidDoc = uid( ora );
+        assert( !uidDoc.empty() && "  UID. ..." );
+        const rev_t& revisionDoc = revision( ora );
+        assert( !revisionDoc.empty() && "  . ..." );
+        Document doc( comm, name, uidDoc, "", revisionDoc );
+        const bool result = doc.addAttachment( nameFile, "text/plain", dataFile );
+        if ( !result ) {
+            throw CouchFine::Exception( "Could not create attachment '" + nameFile + "' with data '" + dataFile + "'." );
+        }
+    }
+}
+
+
+
+
+
 std::string Database::createBulk(
     const CouchFine::Object&   doc,
     CouchFine::fnCreateJSON_t  fnCreateJSON
 ) {
+    /* -    'doc'   UID; UID 
+          . . . .
     // ,      UID  
     if (accUID.size() == 0) {
         accUID = getUUIDs( 100 );
@@ -394,9 +976,43 @@ std::string Database::createBulk(
     //      ,    
     //  
     acc.push_back( typelib::json::cjv( doc ) );
+    */
+
+    //   UID  ID    
+    std::string id = CouchFine::uid( doc );
+    if ( id.empty() ) {
+        // ,      UID  
+        if (accUID.size() == 0) {
+            accUID = getUUIDs( 100 );
+        }
+        id = accUID.back();
+        accUID.pop_back();
+    }
+
+    //  ,    ,  
+    // @see coalesce()
+    if ( accCoalesce ) {
+        const auto ftr = accIndex.find( id );
+        if (ftr != accIndex.end()) {
+            Object& o = acc[ ftr->second ];
+            if ( accMerge ) {
+                accMerge( o, doc );
+            } else {
+                o = doc;
+            }
+            CouchFine::uid( o, id );
+            return id;
+        }
+        accIndex[ id ] = acc.size();
+    }
+
+    //      ,    
+    //  
+    CouchFine::uid( acc.push_back( doc ), id );
     if (acc.size() >= ACC_SIZE) {
         createBulk( acc, fnCreateJSON );
         acc.clear();
+        accIndex.clear();
     }
 
     return id;
@@ -423,6 +1039,72 @@ void Database::createBulk( const std::string&  plainDoc ) {
 
 
 
+void Database::trackDigests( bool on ) {
+    digests = on ? std::shared_ptr< Digests >( new Digests() ) : std::shared_ptr< Digests >();
+}
+
+
+
+
+rev_t Database::unchanged( const Object& doc ) const {
+    if ( !digests ) {
+        return "";
+    }
+    const uid_t& id = CouchFine::uid( doc );
+    if ( id.empty() ) {
+        return "";
+    }
+    const boost::uint64_t h = digest( doc );
+    if (h == 0) {
+        return "";
+    }
+    boost::mutex::scoped_lock  lock( digests->mutex );
+    const auto ftr = digests->known.find( id );
+    return ( (ftr != digests->known.cend()) && (ftr->second.first == h) )
+        ? ftr->second.second
+        : "";
+}
+
+
+
+
+void Database::remember( const Object& doc ) {
+    if ( !digests ) {
+        return;
+    }
+    const uid_t& id = CouchFine::uid( doc );
+    const rev_t& rev = revision( doc );
+    if ( id.empty() || rev.empty() ) {
+        return;
+    }
+    const boost::uint64_t h = digest( doc );
+    boost::mutex::scoped_lock  lock( digests->mutex );
+    if (h == 0) {
+        digests->known.erase( id );
+        return;
+    }
+    digests->known[ id ] = std::make_pair( h, rev );
+}
+
+
+
+
+void Database::coalesce( bool on, fnMerge_t fnMerge ) {
+    accCoalesce = on;
+    accMerge = fnMerge;
+
+    // ,    ,    
+    accIndex.clear();
+    if ( accCoalesce ) {
+        for (size_t i = 0; i < acc.size(); ++i) {
+            accIndex.insert( std::make_pair( CouchFine::uid( acc[ i ] ), i ) );
+        }
+    }
+}
+
+
+
+
 void Database::flush( CouchFine::fnCreateJSON_t fnCreateJSON ) {
 
     //   2 
@@ -430,6 +1112,7 @@ void Database::flush( CouchFine::fnCreateJSON_t fnCreateJSON ) {
     if ( !acc.empty() ) {
         createBulk( acc, fnCreateJSON );
         acc.clear();
+        accIndex.clear();
     }
 
     if ( !accPlain.empty() ) {
@@ -455,18 +1138,20 @@ void Database::deleteDocument( const std::string& id, const std::string& rev ) {
 
     const std::string url = "/" + name + "/" + id;
 
+    std::string currentRev = rev;
     if ( rev.empty() ) {
         //   
-        // @todo optimize?
+        // @todo optimize? . deleteBulk().
         const Variant var = comm.getData( url );
         const Object obj = boost::any_cast< Object >( *var );
         if ( hasError( obj ) ) {
             throw error( obj );
         }
+        currentRev = revision( obj );
     }
 
     //  
-    const Variant var = comm.getData( url + "?rev=" + rev, "DELETE" );
+    const Variant var = comm.getData( url + "?rev=" + currentRev, "DELETE" );
     const Object obj = boost::any_cast< Object >( *var );
     if ( hasError( obj ) ) {
         throw error( obj );
@@ -504,6 +1189,20 @@ void Database::addView(
     CouchFine::Object jo = boost::any_cast< CouchFine::Object >( *jv );
     auto ds = boost::any_cast< CouchFine::Object >( *jo["views"] );
 
+    //    -  :  design-.
+    //    
+    const auto vtr = ds.find( name );
+    if (vtr != ds.cend()) {
+        const CouchFine::Object& old = boost::any_cast< const CouchFine::Object& >( *vtr->second );
+        const auto otm = old.find( "map" );
+        const auto otr = old.find( "reduce" );
+        const std::string oldMap = (otm == old.cend()) ? "" : boost::any_cast< std::string >( *otm->second );
+        const std::string oldReduce = (otr == old.cend()) ? "" : boost::any_cast< std::string >( *otr->second );
+        if ( (oldMap == map) && (oldReduce == reduce) ) {
+            return;
+        }
+    }
+
     CouchFine::Object content;
     content["map"] = typelib::json::cjv( map );
     if ( !reduce.empty() ) {
@@ -514,3 +1213,750 @@ void Database::addView(
     jo["views"] = typelib::json::cjv( ds );
     createDocument( typelib::json::cjv( jo ), designUID );
 }
+
+
+
+
+bool Database::warmView(
+    const std::string& viewName,
+    const std::string& designName,
+    fnProgress_t fnProgress,
+    size_t pollInterval
+) {
+    std::vector< std::pair< std::string, std::string > >  views;
+    views.push_back( std::make_pair( getDesignUID( designName ), viewName ) );
+    return warm( views, fnProgress, pollInterval );
+}
+
+
+
+
+bool Database::warmDesign(
+    const std::string& designName,
+    fnProgress_t fnProgress,
+    size_t pollInterval
+) {
+    return warmDesign( std::vector< std::string >( 1, designName ), fnProgress, pollInterval );
+}
+
+
+
+
+bool Database::warmDesign(
+    const std::vector< std::string >&  designNames,
+    fnProgress_t fnProgress,
+    size_t pollInterval
+) {
+    //      design-,
+    //      
+    std::vector< std::pair< std::string, std::string > >  views;
+    for (auto itr = designNames.cbegin(); itr != designNames.cend(); ++itr) {
+        const std::string designUID = getDesignUID( *itr );
+        const Variant var = comm.getData( "/" + name + "/" + designUID );
+        const Object obj = boost::any_cast< Object >( *var );
+        if ( hasError( obj ) ) {
+            throw Exception( "Design '" + designUID + "': " + error( obj ) );
+        }
+        const auto ftr = obj.find( "views" );
+        if (ftr == obj.cend()) {
+            continue;
+        }
+        const Object design = boost::any_cast< Object >( *ftr->second );
+        if ( !design.empty() ) {
+            views.push_back( std::make_pair( designUID, design.cbegin()->first ) );
+        }
+    }
+    return warm( views, fnProgress, pollInterval );
+}
+
+
+
+
+bool Database::warm(
+    const std::vector< std::pair< std::string, std::string > >&  views,
+    fnProgress_t fnProgress,
+    size_t pollInterval
+) {
+    if ( views.empty() ) {
+        return true;
+    }
+
+    //     .   ,
+    //    .
+    std::vector< Communication::Request >  trigger;
+    for (auto itr = views.cbegin(); itr != views.cend(); ++itr) {
+        trigger.push_back( Communication::Request(
+            "/" + name + "/" + itr->first + "/_view/" + itr->second + "?stale=update_after&limit=0"
+        ) );
+    }
+    const std::vector< Variant >  triggered = comm.getDataBatch( trigger );
+    for (size_t i = 0; i < triggered.size(); ++i) {
+        if ( hasError( triggered[ i ] ) ) {
+            throw Exception( "View '" + views[ i ].second + "': " + error( triggered[ i ] ) );
+        }
+    }
+
+    // ,   .  CouchDB 2.x   
+    //  : 'database'  "shards/00000000-1fffffff/name.1234567890".
+    std::set< std::string >  designs;
+    for (auto itr = views.cbegin(); itr != views.cend(); ++itr) {
+        designs.insert( itr->first );
+    }
+    const std::string shard = "/" + name + ".";
+    std::vector< std::pair< std::string, std::string > >  pending = views;
+    while ( !pending.empty() ) {
+        if ( comm.deadline().over() ) {
+            return false;
+        }
+
+        // /_active_tasks   .  
+        //   :    .
+        const Variant active = comm.getData( "/_active_tasks" );
+        const Array tasks = ( !hasError( active ) && active && (active->type() == typeid( Array )) )
+            ? boost::any_cast< Array >( *active )
+            : Array();
+        size_t count = 0;
+        size_t progress = 0;
+        for (auto itr = tasks.cbegin(); itr != tasks.cend(); ++itr) {
+            const Object task = boost::any_cast< Object >( **itr );
+            const auto type = task.find( "type" );
+            const auto db = task.find( "database" );
+            const auto design = task.find( "design_document" );
+            if ( (type == task.cend()) || (db == task.cend()) || (design == task.cend())
+              || (boost::any_cast< std::string >( *type->second ) != "indexer")
+              || !designs.count( boost::any_cast< std::string >( *design->second ) )
+            ) {
+                continue;
+            }
+            const std::string database = boost::any_cast< std::string >( *db->second );
+            if ( (database != name) && (database.find( shard ) == std::string::npos) ) {
+                continue;
+            }
+            ++count;
+            const auto ftr = task.find( "progress" );
+            progress += (ftr == task.cend()) ? 0 : static_cast< size_t >( ftr->second );
+        }
+
+        if (count > 0) {
+            if ( fnProgress ) {
+                fnProgress( progress / count );
+            }
+            const size_t pause = comm.deadline().remaining( pollInterval );
+            boost::this_thread::sleep_for( boost::chrono::milliseconds( std::min( pause, pollInterval ) ) );
+            continue;
+        }
+
+        //  :         .
+        //    -   .
+        std::string failed;
+        try {
+            for (auto itr = pending.begin(); itr != pending.end(); ) {
+                const Variant probe = comm.getData(
+                    "/" + name + "/" + itr->first + "/_view/" + itr->second + "?limit=0"
+                );
+                if ( hasError( probe ) ) {
+                    // 'timeout' -    :  
+                    if (v< std::string >( boost::any_cast< Object >( *probe ), "error" ) != "timeout") {
+                        failed = "View '" + itr->second + "': " + error( probe );
+                    }
+                    break;
+                }
+                itr = pending.erase( itr );
+            }
+        } catch ( const Exception& ) {
+            //  :   
+            if ( comm.deadline().over() ) {
+                return false;
+            }
+        }
+        if ( !failed.empty() ) {
+            throw Exception( failed );
+        }
+    }
+
+    if ( fnProgress ) {
+        fnProgress( 100 );
+    }
+    return true;
+}
+
+
+
+
+CouchFine::Array Database::deleteBulk(
+    const std::vector< uid_t >&  ids,
+    size_t batchSize
+) {
+    assert( (batchSize > 0) && "     0." );
+
+    Array result( ids.size() );
+    const auto fail = [ &result, &ids ] ( size_t i, const std::string& error, const std::string& reason ) {
+        Object o;
+        o[ "id" ] = typelib::json::cjv( ids[ i ] );
+        o[ "error" ] = typelib::json::cjv( error );
+        o[ "reason" ] = typelib::json::cjv( reason );
+        result[ i ] = typelib::json::cjv( o );
+    };
+
+    //    ,    
+    Array stubs;
+    //    'ids'
+    std::vector< size_t >  stubIndex;
+
+    for (size_t begin = 0; (begin < ids.size()) || !stubs.empty(); begin += batchSize) {
+        const size_t end = std::min( begin + batchSize, ids.size() );
+
+        //        -
+        // 
+        std::vector< Communication::Request >  requests;
+        if ( !stubs.empty() ) {
+            Object o;
+            o[ "docs" ] = typelib::json::cjv( stubs );
+            requests.push_back( Communication::Request(
+                "/" + name + "/_bulk_docs", "POST", createJSON( typelib::json::cjv( o ) )
+            ) );
+        }
+        if (begin < end) {
+            Array keys;
+            for (size_t i = begin; i < end; ++i) {
+                keys.push_back( typelib::json::cjv( ids[ i ] ) );
+            }
+            Object o;
+            o[ "keys" ] = typelib::json::cjv( keys );
+            requests.push_back( Communication::Request(
+                "/" + name + "/_all_docs", "POST", createJSON( typelib::json::cjv( o ) )
+            ) );
+        }
+        const std::vector< Variant >  responses = comm.getDataBatch( requests );
+        size_t k = 0;
+
+        if ( !stubs.empty() ) {
+            const Variant& var = responses[ k++ ];
+            if ( hasError( var ) ) {
+                //     
+                const Object o = boost::any_cast< Object >( *var );
+                const std::string e = boost::any_cast< std::string >( *o.at( "error" ) );
+                const auto ftr = o.find( "reason" );
+                const std::string reason = (ftr == o.cend()) ? "" : boost::any_cast< std::string >( *ftr->second );
+                for (auto itr = stubIndex.cbegin(); itr != stubIndex.cend(); ++itr) {
+                    fail( *itr, e, reason );
+                }
+            } else {
+                //  _bulk_docs    
+                const Array ra = boost::any_cast< Array >( *var );
+                for (size_t i = 0; (i < ra.size()) && (i < stubIndex.size()); ++i) {
+                    result[ stubIndex[ i ] ] = ra[ i ];
+                }
+            }
+            stubs.clear();
+            stubIndex.clear();
+        }
+
+        if (begin < end) {
+            const Variant& var = responses[ k++ ];
+            if ( hasError( var ) ) {
+                throw Exception( "Delete bulk: " + error( var ) );
+            }
+            Object o = boost::any_cast< Object >( *var );
+            const Array rows = static_cast< Array >( o[ "rows" ] );
+            for (size_t i = begin; i < end; ++i) {
+                const Object row = boost::any_cast< Object >( *rows.at( i - begin ) );
+                const auto value = row.find( "value" );
+                if ( hasError( row ) || (value == row.cend()) ) {
+                    fail( i, "not_found", "missing" );
+                    continue;
+                }
+                const Object v = boost::any_cast< Object >( *value->second );
+                if (v.find( "deleted" ) != v.cend()) {
+                    fail( i, "not_found", "deleted" );
+                    continue;
+                }
+                Object stub;
+                uid( stub, ids[ i ], boost::any_cast< std::string >( *v.at( "rev" ) ) );
+                stub[ "_deleted" ] = typelib::json::cjv( true );
+                stubs.push_back( typelib::json::cjv( stub ) );
+                stubIndex.push_back( i );
+            }
+        }
+    }
+
+    return result;
+}
+
+
+
+
+CouchFine::Array Database::modifyBulk(
+    const std::vector< uid_t >&  ids,
+    fnModify_t fnModify,
+    size_t retry
+) {
+    Array result( ids.size() );
+    const auto fail = [ &result, &ids ] ( size_t i, const std::string& error, const std::string& reason ) {
+        Object o;
+        o[ "id" ] = typelib::json::cjv( ids[ i ] );
+        o[ "error" ] = typelib::json::cjv( error );
+        o[ "reason" ] = typelib::json::cjv( reason );
+        result[ i ] = typelib::json::cjv( o );
+    };
+
+    //   'ids' ,    
+    std::vector< size_t >  pending;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        pending.push_back( i );
+    }
+
+    for (size_t attempt = 0; !pending.empty() && (attempt <= retry); ++attempt) {
+        // 
+        Array keys;
+        for (auto itr = pending.cbegin(); itr != pending.cend(); ++itr) {
+            keys.push_back( typelib::json::cjv( ids[ *itr ] ) );
+        }
+        Object request;
+        request[ "keys" ] = typelib::json::cjv( keys );
+        const Variant var = comm.getData(
+            "/" + name + "/_all_docs?include_docs=true", "POST", createJSON( typelib::json::cjv( request ) )
+        );
+        if ( hasError( var ) ) {
+            throw Exception( "Modify bulk: " + error( var ) );
+        }
+        Object o = boost::any_cast< Object >( *var );
+        const Array rows = static_cast< Array >( o[ "rows" ] );
+
+        // 
+        Array docs;
+        std::vector< size_t >  docIndex;
+        for (size_t k = 0; k < pending.size(); ++k) {
+            const size_t i = pending[ k ];
+            const Object row = boost::any_cast< Object >( *rows.at( k ) );
+            const auto dtr = row.find( "doc" );
+            Object doc;
+            if ( (dtr != row.cend()) && dtr->second && (dtr->second->type() == typeid( Object )) ) {
+                doc = boost::any_cast< Object >( *dtr->second );
+            } else {
+                //   :   
+                uid( doc, ids[ i ] );
+            }
+            const bool exists = hasRevision( doc );
+            Object changed = doc;
+            if ( !fnModify( changed ) ) {
+                if ( exists ) {
+                    Object r;
+                    r[ "id" ] = typelib::json::cjv( ids[ i ] );
+                    r[ "rev" ] = typelib::json::cjv( revision( doc ) );
+                    result[ i ] = typelib::json::cjv( r );
+                } else {
+                    fail( i, "not_found", "missing" );
+                }
+                continue;
+            }
+            // UID    :   
+            changed.erase( "_rev" );
+            uid( changed, ids[ i ], exists ? revision( doc ) : "" );
+            docs.push_back( typelib::json::cjv( changed ) );
+            docIndex.push_back( i );
+        }
+
+        std::vector< size_t >  conflicts;
+        if ( !docs.empty() ) {
+            // 
+            Object body;
+            body[ "docs" ] = typelib::json::cjv( docs );
+            const Variant wvar = comm.getData(
+                "/" + name + "/_bulk_docs", "POST", createJSON( typelib::json::cjv( body ) )
+            );
+            if ( hasError( wvar ) ) {
+                throw Exception( "Modify bulk: " + error( wvar ) );
+            }
+            const Array ra = boost::any_cast< Array >( *wvar );
+            for (size_t k = 0; (k < ra.size()) && (k < docIndex.size()); ++k) {
+                result[ docIndex[ k ] ] = ra[ k ];
+                const Object r = boost::any_cast< Object >( *ra[ k ] );
+                const auto etr = r.find( "error" );
+                if ( (etr != r.cend()) && (boost::any_cast< std::string >( *etr->second ) == "conflict") ) {
+                    conflicts.push_back( docIndex[ k ] );
+                }
+            }
+        }
+        pending.swap( conflicts );
+    }
+
+    return result;
+}
+
+
+
+
+size_t Database::scan( const Scan& scan, fnRow_t fnRow ) {
+    assert( (scan.pageSize > 0) && "     0." );
+
+    const std::string base = "/" + name + ( scan.view.empty()
+        ? "/_all_docs"
+        : "/" + getDesignUID( scan.design ) + "/_view/" + scan.view );
+    // (!)   'reduce'   
+    const std::string common =
+        std::string( scan.view.empty() ? "" : "reduce=false&" )
+      + std::string( scan.withDoc ? "include_docs=true&" : "" );
+    const std::string limit = "limit=" + boost::lexical_cast< std::string >( scan.pageSize );
+
+    const std::vector< std::string >  bounds =
+        scan.bounds.empty() ? sampleBounds( base, scan ) : scan.bounds;
+
+    //  i -  bounds[ i - 1 ]   bounds[ i ] 
+    std::vector< Partition >  parts( bounds.size() + 1 );
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i > 0) {
+            parts[ i ].next = "startkey=" + encodeKey( bounds[ i - 1 ] ) + "&";
+        } else if ( !scan.startkey.empty() ) {
+            parts[ i ].next = "startkey=" + encodeKey( scan.startkey ) + "&";
+        }
+        if (i < bounds.size()) {
+            parts[ i ].end = "endkey=" + encodeKey( bounds[ i ] ) + "&inclusive_end=false&";
+        } else if ( !scan.endkey.empty() ) {
+            parts[ i ].end = "endkey=" + encodeKey( scan.endkey ) + "&";
+        }
+    }
+
+    size_t count = 0;
+    // ,     'scan.ordered'
+    size_t current = 0;
+    for ( ;; ) {
+        //      .  'ordered' 
+        //      'lookahead' .
+        std::vector< Communication::Request >  requests;
+        std::vector< size_t >  index;
+        for (size_t i = 0; i < parts.size(); ++i) {
+            const Partition& part = parts[ i ];
+            if ( part.done || (scan.ordered && (i > current) && (part.pages.size() >= scan.lookahead)) ) {
+                continue;
+            }
+            requests.push_back( Communication::Request( base + "?" + common + part.next + part.end + limit ) );
+            index.push_back( i );
+        }
+        if ( requests.empty() ) {
+            break;
+        }
+
+        const std::vector< Variant >  responses = comm.getDataBatch( requests, requests.size() );
+        for (size_t k = 0; k < responses.size(); ++k) {
+            if ( hasError( responses[ k ] ) ) {
+                throw Exception( "Scan '" + base + "': " + error( responses[ k ] ) );
+            }
+            Partition& part = parts[ index[ k ] ];
+            Object o = boost::any_cast< Object >( *responses[ k ] );
+            const Array rows = static_cast< Array >( o[ "rows" ] );
+            if (rows.size() < scan.pageSize) {
+                part.done = true;
+            } else {
+                //   -    .
+                //     :  UID.
+                const Object last = boost::any_cast< Object >( *rows.back() );
+                part.next = "startkey=" + encodeKey( createJSON( last.at( "key" ) ) ) + "&"
+                    + ( scan.view.empty() ? "" : "startkey_docid=" + encodeKey( uid( last ) ) + "&" )
+                    + "skip=1&";
+            }
+
+            if ( scan.ordered ) {
+                part.pages.push_back( rows );
+                continue;
+            }
+            for (auto itr = rows.cbegin(); itr != rows.cend(); ++itr) {
+                ++count;
+                if ( !fnRow( boost::any_cast< const Object& >( **itr ) ) ) {
+                    return count;
+                }
+            }
+        }
+
+        //        :  ,
+        //    ,  
+        while ( scan.ordered && (current < parts.size()) ) {
+            Partition& part = parts[ current ];
+            for ( ; !part.pages.empty(); part.pages.pop_front()) {
+                const Array& rows = part.pages.front();
+                for (auto itr = rows.cbegin(); itr != rows.cend(); ++itr) {
+                    ++count;
+                    if ( !fnRow( boost::any_cast< const Object& >( **itr ) ) ) {
+                        return count;
+                    }
+                }
+            }
+            if ( !part.done ) {
+                break;
+            }
+            ++current;
+        }
+    }
+
+    return count;
+}
+
+
+
+
+std::vector< std::string >  Database::sampleBounds( const std::string& base, const Scan& scan ) {
+    const std::string common = scan.view.empty() ? "" : "reduce=false&";
+    const std::string start = scan.startkey.empty()
+        ? "" : "startkey=" + encodeKey( scan.startkey ) + "&";
+
+    //          :
+    // 'offset' - -     
+    std::vector< Communication::Request >  requests;
+    requests.push_back( Communication::Request( base + "?" + common + start + "limit=1" ) );
+    requests.push_back( Communication::Request( scan.endkey.empty()
+        ? base + "?" + common + "descending=true&limit=1"
+        : base + "?" + common + "startkey=" + encodeKey( scan.endkey ) + "&limit=0"
+    ) );
+    std::vector< Variant >  responses = comm.getDataBatch( requests );
+    for (auto itr = responses.cbegin(); itr != responses.cend(); ++itr) {
+        if ( hasError( *itr ) ) {
+            throw Exception( "Scan '" + base + "': " + error( *itr ) );
+        }
+    }
+    Object o = boost::any_cast< Object >( *responses.front() );
+    Object e = boost::any_cast< Object >( *responses.back() );
+    const Array firstRows = static_cast< Array >( o[ "rows" ] );
+    const Array lastRows = scan.endkey.empty() ? static_cast< Array >( e[ "rows" ] ) : Array();
+    if ( firstRows.empty() || (scan.endkey.empty() && lastRows.empty()) ) {
+        return std::vector< std::string >();
+    }
+    const size_t first = static_cast< size_t >( o[ "offset" ] );
+    const size_t last = scan.endkey.empty()
+        ? static_cast< size_t >( o[ "total_rows" ] )
+        : static_cast< size_t >( e[ "offset" ] );
+    const size_t count = (last > first) ? (last - first) : 0;
+
+    //    
+    const size_t n = std::max( static_cast< size_t >( 1 ), std::min(
+        scan.partitions, (count + scan.pageSize - 1) / scan.pageSize
+    ) );
+    if (n < 2) {
+        return std::vector< std::string >();
+    }
+
+    // (!) 'skip' CouchDB    :  
+    //   .    : 
+    //  ('startkey'  limit=0)     .
+    //   -   ;  
+    //   .
+    std::vector< Probe >  probes;
+    probes.push_back( Probe(
+        boost::any_cast< const Object& >( *firstRows.front() ).at( "key" ), first, false
+    ) );
+    probes.push_back( scan.endkey.empty()
+        ? Probe( boost::any_cast< const Object& >( *lastRows.front() ).at( "key" ), last - 1, false )
+        : Probe( Communication::parseData( scan.endkey ), last, false )
+    );
+    std::set< std::string >  known;
+
+    //      ,  1/8 , - 
+    const size_t tolerance = std::max( static_cast< size_t >( 1 ), count / (n * 8) );
+    const size_t MAX_ROUNDS = 32;
+    std::vector< bool >  settled( n, false );
+    for (size_t round = 0; round < MAX_ROUNDS; ++round) {
+        requests.clear();
+        std::vector< std::string >  keys;
+        //    ,   
+        std::vector< size_t >  above;
+        for (size_t i = 1; i < n; ++i) {
+            if ( settled[ i ] ) {
+                continue;
+            }
+            const size_t target = first + i * count / n;
+            size_t h = 0;
+            while ( (h < probes.size()) && (probes[ h ].rank <= target) ) {
+                ++h;
+            }
+            if ( (h == 0) || (h == probes.size()) ) {
+                settled[ i ] = true;
+                continue;
+            }
+            const Probe& lo = probes[ h - 1 ];
+            const Probe& hi = probes[ h ];
+            if ( (lo.bound && (target - lo.rank <= tolerance))
+              || (hi.bound && (hi.rank - target <= tolerance))
+            ) {
+                settled[ i ] = true;
+                continue;
+            }
+            //       :   
+            const std::string mid = middleKey( lo.key, hi.key );
+            if ( mid.empty() || (known.count( mid ) > 0) ) {
+                settled[ i ] = true;
+                continue;
+            }
+            if (std::find( keys.cbegin(), keys.cend(), mid ) == keys.cend()) {
+                keys.push_back( mid );
+                above.push_back( hi.rank );
+                requests.push_back( Communication::Request(
+                    base + "?" + common + "startkey=" + encodeKey( mid ) + "&limit=0"
+                ) );
+            }
+        }
+        if ( requests.empty() ) {
+            break;
+        }
+
+        responses = comm.getDataBatch( requests, requests.size() );
+        for (size_t k = 0; k < responses.size(); ++k) {
+            if ( hasError( responses[ k ] ) ) {
+                throw Exception( "Scan '" + base + "': " + error( responses[ k ] ) );
+            }
+            Object r = boost::any_cast< Object >( *responses[ k ] );
+            const size_t rank = static_cast< size_t >( r[ "offset" ] );
+            //        :
+            //      
+            auto itr = probes.begin();
+            while ( (itr != probes.end())
+                && ((itr->rank < rank) || ((itr->rank == rank) && (rank < above[ k ])))
+            ) {
+                ++itr;
+            }
+            probes.insert( itr, Probe( Communication::parseData( keys[ k ] ), rank, true, keys[ k ] ) );
+            known.insert( keys[ k ] );
+        }
+    }
+
+    //    -  .     
+    //    :   .
+    std::map< size_t, std::string >  chosen;
+    for (size_t i = 1; i < n; ++i) {
+        const size_t target = first + i * count / n;
+        const Probe* best = nullptr;
+        for (auto itr = probes.cbegin(); itr != probes.cend(); ++itr) {
+            if ( !itr->bound || (itr->rank <= first) || (itr->rank >= last) ) {
+                continue;
+            }
+            const size_t d = (itr->rank > target) ? (itr->rank - target) : (target - itr->rank);
+            const size_t bestD = !best ? 0
+                : (best->rank > target) ? (best->rank - target) : (target - best->rank);
+            if ( !best || (d < bestD) ) {
+                best = &*itr;
+            }
+        }
+        if ( best ) {
+            chosen[ best->rank ] = best->json;
+        }
+    }
+
+    std::vector< std::string >  bounds;
+    for (auto itr = chosen.cbegin(); itr != chosen.cend(); ++itr) {
+        bounds.push_back( itr->second );
+    }
+    return bounds;
+}
+
+
+
+
+Object Database::find( const std::string& query ) {
+    const Variant var = comm.getData( "/" + name + "/_find", "POST", query );
+    if ( hasError( var ) ) {
+        throw Exception( "Find: " + error( var ) );
+    }
+    return boost::any_cast< Object >( *var );
+}
+
+
+
+
+size_t Database::find( const Mode::Find& query, fnRow_t fnRow, size_t pageSize ) {
+    assert( (pageSize > 0) && "     0." );
+
+    Mode::Find page( query );
+    size_t count = 0;
+    while ( (query.limit == 0) || (count < query.limit) ) {
+        //   -     'limit'
+        const size_t n = (query.limit > 0) ? std::min( pageSize, query.limit - count ) : pageSize;
+        Object o = find( page.json( n ) );
+        const Array docs = static_cast< Array >( o[ "docs" ] );
+        for (auto itr = docs.cbegin(); itr != docs.cend(); ++itr) {
+            ++count;
+            if ( !fnRow( boost::any_cast< const Object& >( **itr ) ) ) {
+                return count;
+            }
+        }
+        const auto ftr = o.find( "bookmark" );
+        if ( (docs.size() < n) || (ftr == o.cend()) ) {
+            break;
+        }
+        const std::string bookmark = boost::any_cast< std::string >( *ftr->second );
+        if (bookmark == page.bookmark) {
+            break;
+        }
+        page.bookmark = bookmark;
+        page.skip = 0;
+    }
+
+    return count;
+}
+
+
+
+
+Object Database::createIndex(
+    const std::vector< std::string >&  fields,
+    const std::string& indexName,
+    const std::string& designName
+) {
+    assert( !fields.empty() && "    ." );
+
+    Array a;
+    for (auto itr = fields.cbegin(); itr != fields.cend(); ++itr) {
+        a.push_back( typelib::json::cjv( *itr ) );
+    }
+    Object index;
+    index[ "fields" ] = typelib::json::cjv( a );
+    Object request;
+    request[ "index" ] = typelib::json::cjv( index );
+    if ( !indexName.empty() ) {
+        request[ "name" ] = typelib::json::cjv( indexName );
+    }
+    if ( !designName.empty() ) {
+        request[ "ddoc" ] = typelib::json::cjv( designName );
+    }
+
+    const Variant var = comm.getData( "/" + name + "/_index", "POST", createJSON( typelib::json::cjv( request ) ) );
+    if ( hasError( var ) ) {
+        throw Exception( "Index: " + error( var ) );
+    }
+    return boost::any_cast< Object >( *var );
+}
+
+
+
+
+Array Database::indexes() {
+    const Variant var = comm.getData( "/" + name + "/_index" );
+    if ( hasError( var ) ) {
+        throw Exception( "Index: " + error( var ) );
+    }
+    Object o = boost::any_cast< Object >( *var );
+    return static_cast< Array >( o[ "indexes" ] );
+}
+
+
+
+
+Object Database::changes(
+    const std::string& since,
+    bool includeDocs,
+    size_t limit,
+    size_t longpoll
+) {
+    std::string url = "/" + name + "/_changes?since=" + encodeKey( since );
+    if ( includeDocs ) {
+        url += "&include_docs=true";
+    }
+    if (limit > 0) {
+        url += "&limit=" + boost::lexical_cast< std::string >( limit );
+    }
+    if (longpoll > 0) {
+        url += "&feed=longpoll&timeout=" + boost::lexical_cast< std::string >( longpoll );
+    }
+    const Variant var = comm.getData( url );
+    if ( hasError( var ) ) {
+        throw Exception( "Changes: " + error( var ) );
+    }
+    return boost::any_cast< Object >( *var );
+}
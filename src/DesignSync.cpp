@@ -0,0 +1,261 @@
+#include "../include/DesignSync.h"
+#include "../include/Exception.h"
+#include <typelib/typelib.h>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+
+
+using namespace CouchFine;
+
+
+namespace {
+
+/**
+* @return true,       'views'.
+*/
+bool sameViews( const Object& server, const std::vector< View >&  views ) {
+    if (server.size() != views.size()) {
+        return false;
+    }
+    for (auto itr = views.cbegin(); itr != views.cend(); ++itr) {
+        const auto ftr = server.find( itr->name );
+        if ( (ftr == server.cend()) || (ftr->second->type() != typeid( Object )) ) {
+            return false;
+        }
+        const Object& content = boost::any_cast< const Object& >( *ftr->second );
+        const auto map = content.find( "map" );
+        const auto reduce = content.find( "reduce" );
+        const std::string sMap = (map == content.cend())
+            ? "" : boost::any_cast< std::string >( *map->second );
+        const std::string sReduce = (reduce == content.cend())
+            ? "" : boost::any_cast< std::string >( *reduce->second );
+        if ( (sMap != itr->map) || (sReduce != itr->reduce) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+
+
+DesignSync::DesignSync(
+    const std::string& root,
+    const std::map< std::string, std::string >&  context,
+    size_t threads
+) {
+    namespace fs = boost::filesystem;
+
+    if ( !fs::is_directory( root ) ) {
+        throw Exception( "Folder '" + root + "' is not exists." );
+    }
+
+    //   : ( design-., )
+    std::vector< std::pair< size_t, std::string > >  folders;
+    std::vector< fs::path >  designFolders;
+    for (fs::directory_iterator itr( root ); itr != fs::directory_iterator(); ++itr) {
+        if ( fs::is_directory( itr->status() ) ) {
+            designFolders.push_back( itr->path() );
+        }
+    }
+    std::sort( designFolders.begin(), designFolders.end() );
+    for (auto dtr = designFolders.cbegin(); dtr != designFolders.cend(); ++dtr) {
+        Design design;
+        design.name = dtr->filename().string();
+        std::vector< fs::path >  viewFolders;
+        for (fs::directory_iterator itr( *dtr ); itr != fs::directory_iterator(); ++itr) {
+            if ( fs::exists( itr->path() / "map.js" ) ) {
+                viewFolders.push_back( itr->path() );
+            }
+        }
+        //    -  design- (.git, .svn  ..)
+        if ( viewFolders.empty() ) {
+            continue;
+        }
+        //     
+        std::sort( viewFolders.begin(), viewFolders.end() );
+        for (auto itr = viewFolders.cbegin(); itr != viewFolders.cend(); ++itr) {
+            folders.push_back( std::make_pair( designList.size(), itr->string() ) );
+        }
+        designList.push_back( design );
+    }
+
+    //   
+    std::vector< std::shared_ptr< View > >  loaded( folders.size() );
+    boost::atomic< size_t >  next( 0 );
+    boost::mutex errorLock;
+    std::string errorMessage;
+    const auto worker = [ &folders, &context, &loaded, &next, &errorLock, &errorMessage ] () {
+        for (size_t i = next++; i < folders.size(); i = next++) {
+            try {
+                loaded[ i ] = std::shared_ptr< View >(
+                    new View( View::valueOf( folders[ i ].second, context ) )
+                );
+            } catch ( const std::exception& ex ) {
+                boost::mutex::scoped_lock lock( errorLock );
+                errorMessage = "View '" + folders[ i ].second + "': " + ex.what();
+            }
+        }
+    };
+    boost::thread_group group;
+    const size_t n = std::min( std::max( threads, static_cast< size_t >( 1 ) ), folders.size() );
+    for (size_t k = 1; k < n; ++k) {
+        group.create_thread( worker );
+    }
+    worker();
+    group.join_all();
+    if ( !errorMessage.empty() ) {
+        throw Exception( errorMessage );
+    }
+
+    for (size_t i = 0; i < folders.size(); ++i) {
+        designList[ folders[ i ].first ].views.push_back( *loaded[ i ] );
+    }
+    for (auto itr = designList.begin(); itr != designList.end(); ++itr) {
+        itr->hash = hashOf( itr->views );
+    }
+}
+
+
+
+
+std::vector< std::string >  DesignSync::names() const {
+    std::vector< std::string >  r;
+    for (auto itr = designList.cbegin(); itr != designList.cend(); ++itr) {
+        r.push_back( itr->name );
+    }
+    return r;
+}
+
+
+
+
+Array DesignSync::changes( Database& db ) const {
+    if ( designList.empty() ) {
+        return Array();
+    }
+
+    //  design- -  
+    Array keys;
+    for (auto itr = designList.cbegin(); itr != designList.cend(); ++itr) {
+        keys.push_back( typelib::json::cjv( db.getDesignUID( itr->name ) ) );
+    }
+    Object request;
+    request[ "keys" ] = typelib::json::cjv( keys );
+    std::ostringstream ostr;
+    ::operator<<( ostr, typelib::json::cjv( request ) );
+    const Variant var = db.getCommunication().getData(
+        "/" + db.getName() + "/_all_docs?include_docs=true", "POST", ostr.str()
+    );
+    if ( hasError( var ) ) {
+        throw Exception( "Design documents: " + error( var ) );
+    }
+    Object o = boost::any_cast< Object >( *var );
+    const Array rows = static_cast< Array >( o[ "rows" ] );
+    assert( (rows.size() == designList.size())
+        && "      ." );
+
+    Array r;
+    for (size_t i = 0; i < designList.size(); ++i) {
+        const Design& design = designList[ i ];
+        const Object row = boost::any_cast< Object >( *rows.at( i ) );
+        const auto ftr = row.find( "doc" );
+        Object doc;
+        if ( (ftr != row.cend()) && ftr->second && (ftr->second->type() == typeid( Object )) ) {
+            doc = boost::any_cast< Object >( *ftr->second );
+        }
+
+        if ( !doc.empty() ) {
+            const auto htr = doc.find( HASH() );
+            if ( (htr != doc.cend()) && (boost::any_cast< std::string >( *htr->second ) == design.hash) ) {
+                continue;
+            }
+            //    (,  Database::addView()), 
+            // :  ,    
+            const auto vtr = doc.find( "views" );
+            if ( (vtr != doc.cend()) && (vtr->second->type() == typeid( Object ))
+              && sameViews( boost::any_cast< const Object& >( *vtr->second ), design.views )
+            ) {
+                continue;
+            }
+        } else {
+            uid( doc, db.getDesignUID( design.name ) );
+            doc[ "language" ] = typelib::json::cjv( std::string( "javascript" ) );
+        }
+
+        Object views;
+        for (auto itr = design.views.cbegin(); itr != design.views.cend(); ++itr) {
+            Object content;
+            content[ "map" ] = typelib::json::cjv( itr->map );
+            if ( !itr->reduce.empty() ) {
+                content[ "reduce" ] = typelib::json::cjv( itr->reduce );
+            }
+            views[ itr->name ] = typelib::json::cjv( content );
+        }
+        doc[ "views" ] = typelib::json::cjv( views );
+        doc[ HASH() ] = typelib::json::cjv( design.hash );
+        r.push_back( typelib::json::cjv( doc ) );
+    }
+
+    return r;
+}
+
+
+
+
+std::vector< std::string >  DesignSync::apply( Database& db ) const {
+    const Array docs = changes( db );
+    if ( docs.empty() ) {
+        return std::vector< std::string >();
+    }
+
+    Object request;
+    request[ "docs" ] = typelib::json::cjv( docs );
+    std::ostringstream ostr;
+    ::operator<<( ostr, typelib::json::cjv( request ) );
+    const Variant var = db.getCommunication().getData(
+        "/" + db.getName() + "/_bulk_docs", "POST", ostr.str()
+    );
+    if ( hasError( var ) ) {
+        throw Exception( "Design documents: " + error( var ) );
+    }
+
+    std::vector< std::string >  r;
+    const Array ra = boost::any_cast< Array >( *var );
+    for (auto itr = ra.cbegin(); itr != ra.cend(); ++itr) {
+        const Object o = boost::any_cast< Object >( **itr );
+        if ( hasError( o ) ) {
+            throw Exception( "Design '" + uid( o ) + "': " + error( o ) );
+        }
+        r.push_back( uid( o ) );
+    }
+
+    return r;
+}
+
+
+
+
+std::string DesignSync::hashOf( const std::vector< View >&  views ) {
+    std::vector< const View* >  sorted;
+    for (auto itr = views.cbegin(); itr != views.cend(); ++itr) {
+        sorted.push_back( &( *itr ) );
+    }
+    std::sort( sorted.begin(), sorted.end(), [] ( const View* a, const View* b ) -> bool {
+        return a->name < b->name;
+    } );
+
+    //  '\0'     
+    std::string s;
+    for (auto itr = sorted.cbegin(); itr != sorted.cend(); ++itr) {
+        s += (*itr)->name;
+        s += '\0';
+        s += (*itr)->map;
+        s += '\0';
+        s += (*itr)->reduce;
+        s += '\0';
+    }
+    return typelib::hash::sha1( s );
+}
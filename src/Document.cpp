@@ -272,8 +272,13 @@ Document Document::copy( const uid_t& targetId, const rev_t& targetRev ) {
 Document Document::update( Database& db, const Object& jo ) {
 
     Object o = jo;
+    /* - CouchDB  '_id'  '_rev'. . . .
     o["id"] = typelib::json::cjv( getID() );
     o["rev"] = typelib::json::cjv( getRevision() );
+    */
+    o.erase( "id" );
+    o.erase( "rev" );
+    CouchFine::uid( o, getID(), getRevision() );
     const auto doc = db.createDocument( typelib::json::cjv( o ), getID() );
 
     return doc;
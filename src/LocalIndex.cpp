@@ -0,0 +1,450 @@
+#include "../include/LocalIndex.h"
+#include "../include/Exception.h"
+#include "../include/Scan.h"
+#include <set>
+#include <sstream>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+
+using namespace CouchFine;
+
+
+
+
+namespace {
+
+/**
+* @return   : CouchDB 1.x  , 2.x - .
+*/
+std::string seqString( const Variant& seq ) {
+    //  "0"      
+    if ( !seq ) {
+        throw Exception( "Local index: update sequence is missing in the response." );
+    }
+    if (seq->type() == typeid( std::string )) {
+        return boost::any_cast< std::string >( *seq );
+    }
+    std::ostringstream ostr;
+    ::operator<<( ostr, seq );
+    return ostr.str();
+}
+
+} // namespace
+
+
+
+
+LocalIndex::LocalIndex(
+    Database& store,
+    fnMap_t fnMap,
+    Kind kind,
+    const std::string& design,
+    const std::string& view
+) :
+    store( store ),
+    fnMap( fnMap ),
+    kind( kind ),
+    design( design ),
+    view( view ),
+    current( boost::make_shared< Snapshot >() ),
+    publishInterval( 100 ),
+    generation( 0 ),
+    bootstrapping( 0 ),
+    stopping( false )
+{
+}
+
+
+
+
+LocalIndex::~LocalIndex() {
+    stop();
+}
+
+
+
+
+size_t LocalIndex::bootstrap() {
+    //  long-poll :      
+    ++bootstrapping;
+    {
+        boost::mutex::scoped_lock  lock( writing );
+        polling.cancel();
+    }
+    boost::mutex::scoped_lock  request( requesting );
+    --bootstrapping;
+    boost::mutex::scoped_lock  lock( writing );
+
+    const boost::shared_ptr< Snapshot >  s = boost::make_shared< Snapshot >();
+    s->seq = seqString( store.about()[ "update_seq" ] );
+    docKeys.clear();
+    shared.clear();
+    ++generation;
+
+    Scan scan( design, view );
+    scan.withDoc = true;
+    size_t count = 0;
+    std::set< uid_t >  seen;
+    store.scan( scan, [ this, &s, &count, &seen ] ( const Object& row ) -> bool {
+        const auto dtr = row.find( "doc" );
+        if ( (dtr == row.cend()) || !dtr->second || (dtr->second->type() != typeid( Object )) ) {
+            return true;
+        }
+        const Object& doc = boost::any_cast< const Object& >( *dtr->second );
+        const uid_t id = uid( doc );
+        //     . 
+        if ( boost::starts_with( id, "_design/" ) || (!view.empty() && !seen.insert( id ).second) ) {
+            return true;
+        }
+        reindex( *s, id, &doc );
+        ++count;
+        return true;
+    } );
+
+    working = s;
+    publish();
+    return count;
+}
+
+
+
+
+size_t LocalIndex::update( size_t longpoll, size_t limit ) {
+    //    'writing': setPublishInterval()  
+    //   long-poll. bootstrap()  , . 'polling'.
+    boost::mutex::scoped_lock  request( requesting );
+    if (bootstrapping.load() > 0) {
+        return 0;
+    }
+    Communication& c = store.getCommunication();
+    const Deadline outer = c.deadline();
+    Deadline poll = outer.infinite() ? Deadline() : Deadline( outer.remaining() );
+    boost::mutex::scoped_lock  lock( writing );
+    const std::string from = working ? working->seq : load()->seq;
+    const size_t started = generation;
+    if ( outer.cancelled() ) {
+        poll.cancel();
+    }
+    polling = poll;
+    lock.unlock();
+
+    Object r;
+    try {
+        Communication::DeadlineScope  scope( c, poll );
+        r = store.changes( from, true, limit, longpoll );
+    } catch ( ... ) {
+        //  bootstrap():    
+        if ( poll.cancelled() && !outer.over() ) {
+            return 0;
+        }
+        throw;
+    }
+    request.unlock();
+    const Array results = static_cast< Array >( r[ "results" ] );
+    const std::string seq = seqString( r[ "last_seq" ] );
+
+    lock.lock();
+    //     :  
+    if ( (generation != started) || (from != (working ? working->seq : load()->seq)) ) {
+        return 0;
+    }
+    if ( results.empty() && (seq == from) ) {
+        if ( working ) {
+            publish();
+        }
+        return 0;
+    }
+
+    //    :  .   
+    //  ,     .
+    if ( !working ) {
+        working = boost::make_shared< Snapshot >( *load() );
+    }
+    Snapshot& s = *working;
+    for (auto itr = results.cbegin(); itr != results.cend(); ++itr) {
+        const Object& change = boost::any_cast< const Object& >( **itr );
+        const uid_t id = v< std::string >( change, "id" );
+        if ( boost::starts_with( id, "_design/" ) ) {
+            continue;
+        }
+        const auto dtr = change.find( "doc" );
+        const bool alive = !v< bool >( change, "deleted", false )
+            && (dtr != change.cend()) && dtr->second
+            && (dtr->second->type() == typeid( Object ));
+        reindex( s, id, alive ? &boost::any_cast< const Object& >( *dtr->second ) : nullptr );
+    }
+    s.seq = seq;
+
+    //   -  ,  -   'publishInterval'
+    const auto elapsed = boost::chrono::duration_cast< boost::chrono::milliseconds >(
+        Deadline::clock_t::now() - published
+    ).count();
+    if ( (results.size() < limit) || (elapsed >= static_cast< boost::int64_t >( publishInterval )) ) {
+        publish();
+    }
+    return results.size();
+}
+
+
+
+
+void LocalIndex::setPublishInterval( size_t ms ) {
+    boost::mutex::scoped_lock  lock( writing );
+    publishInterval = ms;
+}
+
+
+
+
+void LocalIndex::publish() {
+    boost::atomic_store( &current, snapshot_ptr( working ) );
+    working.reset();
+    published = Deadline::clock_t::now();
+}
+
+
+
+
+void LocalIndex::reindex( Snapshot& s, const uid_t& id, const Object* doc ) {
+    const auto ktr = docKeys.find( id );
+    if (ktr != docKeys.end()) {
+        for (auto itr = ktr->second.cbegin(); itr != ktr->second.cend(); ++itr) {
+            //     :   
+            const auto str = shared.find( *itr );
+            if (str != shared.end()) {
+                str->second.erase( id );
+                const auto owner = str->second.crbegin();
+                assign( s, *itr, owner->first, owner->second );
+                if (str->second.size() == 1) {
+                    shared.erase( str );
+                }
+                continue;
+            }
+            const Entry* e = find( s, *itr );
+            if ( e && (e->id == id) ) {
+                assign( s, *itr, "", Variant() );
+            }
+        }
+        docKeys.erase( ktr );
+    }
+
+    if ( doc ) {
+        fnMap( *doc, boost::bind( &LocalIndex::put, this, boost::ref( s ), id, _1, _2 ) );
+    }
+}
+
+
+
+
+void LocalIndex::put( Snapshot& s, const uid_t& id, const std::string& key, const Variant& value ) {
+    docKeys[ id ].push_back( key );
+
+    //     :  
+    auto str = shared.find( key );
+    if (str == shared.end()) {
+        const Entry* e = find( s, key );
+        if ( !e || (e->id == id) ) {
+            assign( s, key, id, value );
+            return;
+        }
+        str = shared.insert( std::make_pair( key, std::map< uid_t, Variant >() ) ).first;
+        str->second[ e->id ] = e->value;
+    }
+    str->second[ id ] = value;
+    const auto owner = str->second.crbegin();
+    assign( s, key, owner->first, owner->second );
+}
+
+
+
+
+LocalIndex::Entry* LocalIndex::find( Snapshot& s, const std::string& key ) const {
+    if (kind == HASH) {
+        const auto etr = s.hash.find( key );
+        return (etr == s.hash.end()) ? nullptr : &etr->second;
+    }
+    const auto etr = s.ordered.find( key );
+    return (etr == s.ordered.end()) ? nullptr : &etr->second;
+}
+
+
+
+
+void LocalIndex::assign( Snapshot& s, const std::string& key, const uid_t& id, const Variant& value ) const {
+    if ( id.empty() ) {
+        if (kind == HASH) {
+            s.hash.erase( key );
+        } else {
+            s.ordered.erase( key );
+        }
+        return;
+    }
+    Entry& e = (kind == HASH) ? s.hash[ key ] : s.ordered[ key ];
+    e.value = value;
+    e.id = id;
+}
+
+
+
+
+void LocalIndex::start( size_t longpoll, size_t pause ) {
+    if ( running() ) {
+        return;
+    }
+    stopping.store( false );
+    cancel = Deadline();
+    thread = boost::thread( boost::bind( &LocalIndex::run, this, longpoll, pause, cancel ) );
+}
+
+
+
+
+void LocalIndex::stop() {
+    if ( !thread.joinable() ) {
+        return;
+    }
+    stopping.store( true );
+    cancel.cancel();
+    {
+        boost::mutex::scoped_lock  lock( writing );
+        polling.cancel();
+    }
+    thread.interrupt();
+    thread.join();
+
+    //    
+    boost::mutex::scoped_lock  lock( writing );
+    if ( working ) {
+        publish();
+    }
+}
+
+
+
+
+bool LocalIndex::running() const {
+    return thread.joinable();
+}
+
+
+
+
+std::string LocalIndex::lastError() const {
+    boost::mutex::scoped_lock  lock( errorMutex );
+    return error;
+}
+
+
+
+
+void LocalIndex::run( size_t longpoll, size_t pause, Deadline deadline ) {
+    //    , . stop()
+    Communication::DeadlineScope  scope( store.getCommunication(), deadline );
+    while ( !stopping.load() ) {
+        std::string e;
+        try {
+            update( longpoll );
+        } catch ( const std::exception& ex ) {
+            e = ex.what();
+        } catch ( ... ) {
+            e = "Local index: update failed.";
+        }
+        if ( stopping.load() ) {
+            break;
+        }
+        {
+            boost::mutex::scoped_lock  lock( errorMutex );
+            error = e;
+        }
+        if ( !e.empty() ) {
+            try {
+                boost::this_thread::sleep( boost::posix_time::milliseconds( pause ) );
+            } catch ( const boost::thread_interrupted& ) {
+                break;
+            }
+        }
+    }
+}
+
+
+
+
+LocalIndex::snapshot_ptr LocalIndex::load() const {
+    return boost::atomic_load( &current );
+}
+
+
+
+
+bool LocalIndex::get( const std::string& key, Variant& value ) const {
+    const snapshot_ptr s = load();
+    if (kind == HASH) {
+        const auto ftr = s->hash.find( key );
+        if (ftr == s->hash.cend()) {
+            return false;
+        }
+        value = ftr->second.value;
+        return true;
+    }
+    const auto ftr = s->ordered.find( key );
+    if (ftr == s->ordered.cend()) {
+        return false;
+    }
+    value = ftr->second.value;
+    return true;
+}
+
+
+
+
+Variant LocalIndex::get( const std::string& key ) const {
+    Variant value;
+    get( key, value );
+    return value;
+}
+
+
+
+
+bool LocalIndex::has( const std::string& key ) const {
+    Variant value;
+    return get( key, value );
+}
+
+
+
+
+size_t LocalIndex::size() const {
+    const snapshot_ptr s = load();
+    return (kind == HASH) ? s->hash.size() : s->ordered.size();
+}
+
+
+
+
+size_t LocalIndex::range( const std::string& from, const std::string& to, fnEntry_t fnEntry ) const {
+    if (kind != ORDERED) {
+        throw Exception( "Local index: range() needs an ORDERED index." );
+    }
+    const snapshot_ptr s = load();
+    size_t count = 0;
+    if ( !to.empty() && (to < from) ) {
+        return count;
+    }
+    const auto end = to.empty() ? s->ordered.cend() : s->ordered.upper_bound( to );
+    for (auto itr = s->ordered.lower_bound( from ); itr != end; ++itr) {
+        ++count;
+        if ( !fnEntry( itr->first, itr->second.value ) ) {
+            break;
+        }
+    }
+    return count;
+}
+
+
+
+
+std::string LocalIndex::seq() const {
+    return load()->seq;
+}
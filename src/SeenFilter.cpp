@@ -0,0 +1,172 @@
+#include "../include/SeenFilter.h"
+#include "../include/Database.h"
+#include "../include/Exception.h"
+#include <cmath>
+#include <limits>
+
+
+using namespace CouchFine;
+
+
+namespace {
+
+//   
+const char MAGIC[] = "CFSEEN1";
+
+//   -.     30 
+//      .
+const size_t MAX_K = 64;
+
+} // namespace
+
+
+
+
+SeenFilter::SeenFilter( size_t expected, double falsePositive ) :
+    n( 0 )
+{
+    assert( (falsePositive > 0.0) && (falsePositive < 1.0)
+        && "       (0; 1)." );
+
+    // m = -n * ln( p ) / ln( 2 )^2, k = m / n * ln( 2 )
+    const double ln2 = std::log( 2.0 );
+    const double e = static_cast< double >( std::max( expected, static_cast< size_t >( 1 ) ) );
+    const double m = std::ceil( -e * std::log( falsePositive ) / (ln2 * ln2) );
+    nbits = std::max( static_cast< boost::uint64_t >( m ), static_cast< boost::uint64_t >( 64 ) );
+    k = std::min( std::max( static_cast< size_t >( std::floor( m / e * ln2 + 0.5 ) ), static_cast< size_t >( 1 ) ), MAX_K );
+    bits.assign( static_cast< size_t >( (nbits + 63) / 64 ), 0 );
+}
+
+
+
+
+void SeenFilter::add( const uid_t& id ) {
+    boost::uint64_t h1, h2;
+    hash( id, h1, h2 );
+    for (size_t i = 0; i < k; ++i) {
+        const boost::uint64_t bit = (h1 + i * h2) % nbits;
+        bits[ static_cast< size_t >( bit >> 6 ) ] |= (static_cast< boost::uint64_t >( 1 ) << (bit & 63));
+    }
+    ++n;
+}
+
+
+
+
+bool SeenFilter::mayContain( const uid_t& id ) const {
+    boost::uint64_t h1, h2;
+    hash( id, h1, h2 );
+    for (size_t i = 0; i < k; ++i) {
+        const boost::uint64_t bit = (h1 + i * h2) % nbits;
+        if ( !(bits[ static_cast< size_t >( bit >> 6 ) ] & (static_cast< boost::uint64_t >( 1 ) << (bit & 63))) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+
+void SeenFilter::clear() {
+    std::fill( bits.begin(), bits.end(), 0 );
+    n = 0;
+}
+
+
+
+
+size_t SeenFilter::seed( Database& db, size_t partitions ) {
+    Scan scan;
+    scan.partitions = partitions;
+    size_t added = 0;
+    db.scan( scan, [ this, &added ] ( const Object& row ) -> bool {
+        const uid_t& id = uid( row );
+        if ( !boost::starts_with( id, "_design/" ) ) {
+            add( id );
+            ++added;
+        }
+        return true;
+    } );
+    return added;
+}
+
+
+
+
+void SeenFilter::save( const std::string& file ) const {
+    std::ofstream out( file.c_str(), std::ios::binary | std::ios::trunc );
+    if ( !out ) {
+        throw Exception( "File '" + file + "' could not be created." );
+    }
+    const boost::uint64_t header[ 3 ] = { nbits, k, n };
+    out.write( MAGIC, sizeof( MAGIC ) );
+    out.write( reinterpret_cast< const char* >( header ), sizeof( header ) );
+    out.write( reinterpret_cast< const char* >( &bits[ 0 ] ), bytes() );
+    if ( !out ) {
+        throw Exception( "File '" + file + "' could not be written." );
+    }
+}
+
+
+
+
+SeenFilter SeenFilter::load( const std::string& file ) {
+    std::ifstream in( file.c_str(), std::ios::binary );
+    if ( !in ) {
+        throw Exception( "File '" + file + "' is not exists." );
+    }
+    in.seekg( 0, std::ios::end );
+    const boost::uint64_t length = static_cast< boost::uint64_t >( in.tellg() );
+    in.seekg( 0, std::ios::beg );
+
+    char magic[ sizeof( MAGIC ) ];
+    boost::uint64_t header[ 3 ];
+    in.read( magic, sizeof( magic ) );
+    in.read( reinterpret_cast< char* >( header ), sizeof( header ) );
+    if ( !in || (std::string( magic, sizeof( magic ) ) != std::string( MAGIC, sizeof( MAGIC ) )) ) {
+        throw Exception( "File '" + file + "' is not a seen filter." );
+    }
+
+    //    -   :  
+    //      .  'k'  
+    //   .
+    const boost::uint64_t words = (header[ 0 ] + 63) / 64;
+    const boost::uint64_t headerSize = sizeof( MAGIC ) + sizeof( header );
+    const boost::uint64_t maxSize = std::numeric_limits< size_t >::max();
+    if ( (header[ 0 ] == 0) || (header[ 1 ] == 0) || (header[ 1 ] > MAX_K)
+      || (header[ 2 ] > maxSize) || (words > maxSize / 8)
+      || (header[ 0 ] > std::numeric_limits< boost::uint64_t >::max() - 63)
+      || (length < headerSize) || ((length - headerSize) / 8 != words) || ((length - headerSize) % 8 != 0)
+    ) {
+        throw Exception( "File '" + file + "' is corrupt." );
+    }
+
+    SeenFilter r( 1 );
+    r.nbits = header[ 0 ];
+    r.k = static_cast< size_t >( header[ 1 ] );
+    r.n = static_cast< size_t >( header[ 2 ] );
+    r.bits.assign( static_cast< size_t >( words ), 0 );
+    in.read( reinterpret_cast< char* >( &r.bits[ 0 ] ), r.bytes() );
+    if ( !in ) {
+        throw Exception( "File '" + file + "' is truncated." );
+    }
+    return r;
+}
+
+
+
+
+void SeenFilter::hash( const uid_t& id, boost::uint64_t& h1, boost::uint64_t& h2 ) const {
+    // FNV-1a
+    h1 = 14695981039346656037ULL;
+    for (auto itr = id.cbegin(); itr != id.cend(); ++itr) {
+        h1 ^= static_cast< unsigned char >( *itr );
+        h1 *= 1099511628211ULL;
+    }
+    //   -   (splitmix64), 
+    h2 = h1 + 0x9E3779B97F4A7C15ULL;
+    h2 = (h2 ^ (h2 >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h2 = (h2 ^ (h2 >> 27)) * 0x94D049BB133111EBULL;
+    h2 = (h2 ^ (h2 >> 31)) | 1;
+}
@@ -0,0 +1,109 @@
+#include "../include/Singleflight.h"
+#include "../include/Exception.h"
+#include <algorithm>
+
+
+using namespace CouchFine;
+
+
+namespace {
+
+/**
+*     , .    .
+*/
+const size_t CANCEL_POLL = 20;
+
+} // namespace
+
+
+
+
+Singleflight::Singleflight() {
+}
+
+
+
+
+Singleflight::Response Singleflight::run( const std::string& key, fnFetch_t fetch, const Deadline& deadline ) {
+
+    boost::mutex::scoped_lock  lock( mutex );
+
+    //    :   ,     
+    for (auto ftr = flights.find( key ); ftr != flights.cend(); ftr = flights.find( key )) {
+        const std::shared_ptr< Flight >  flight = ftr->second;
+        ++counters.collapsed;
+        ++flight->waiters;
+        while ( !flight->done ) {
+            if ( deadline.cancelled() ) {
+                throw Exception( "Operation cancelled: " + key );
+            }
+            if ( deadline.expired() ) {
+                throw Exception( "Deadline exceeded: " + key );
+            }
+            const size_t ms = std::min( deadline.remaining( CANCEL_POLL ), CANCEL_POLL );
+            landed.wait_for( lock, boost::chrono::milliseconds( ms ) );
+        }
+        if ( flight->error.empty() ) {
+            //   'flight'   :   
+            lock.unlock();
+            Response r = flight->response;
+            r.data = deepCopy( r.data );
+            return r;
+        }
+        if ( !flight->expired ) {
+            throw Exception( flight->error );
+        }
+        //   -  :  
+    }
+
+    const std::shared_ptr< Flight >  flight( new Flight() );
+    flights[ key ] = flight;
+    ++counters.flights;
+    lock.unlock();
+
+    //   ,    -  
+    try {
+        flight->response = fetch();
+    } catch ( const std::exception& ex ) {
+        const std::string what = ex.what();
+        land( key, flight, what.empty() ? ("Request failed: " + key) : what, deadline.over() );
+        throw;
+    } catch ( ... ) {
+        land( key, flight, "Request failed: " + key, deadline.over() );
+        throw;
+    }
+
+    //   'flight'    
+    if ( land( key, flight, "", false ) == 0 ) {
+        return flight->response;
+    }
+    Response r = flight->response;
+    r.data = deepCopy( r.data );
+    return r;
+}
+
+
+
+
+size_t Singleflight::land(
+    const std::string&               key,
+    const std::shared_ptr< Flight >&  flight,
+    const std::string&               error,
+    bool                             expired
+) {
+    boost::mutex::scoped_lock  lock( mutex );
+    flight->error = error;
+    flight->expired = expired;
+    flight->done = true;
+    flights.erase( key );
+    landed.notify_all();
+    return flight->waiters;
+}
+
+
+
+
+Singleflight::Stats Singleflight::stats() const {
+    boost::mutex::scoped_lock  lock( mutex );
+    return counters;
+}
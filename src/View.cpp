@@ -1,11 +1,22 @@
 #include "../include/View.h"
-#include "../external/plustache/include/template.hpp"
+#include "../external/plustache/include/compiled_template.hpp"
 #include "../external/plustache/include/context.hpp"
 
 
 using namespace CouchFine;
 
 
+namespace {
+
+/**
+*  .     map.js / reduce.js  
+*    (   -  ).
+*/
+template_cache_t templates;
+
+} // namespace
+
+
 View View::valueOf(
     const std::string& folder,
     const std::map< std::string, std::string >&  context
@@ -15,15 +26,16 @@ View View::valueOf(
     assert( fs::exists( folder ) && "Folder is not exists." );
     assert( fs::is_directory( folder ) && "Path is not directory." );
 
-    //  
-    const std::string name = fs::basename( folder );
-
     const std::string f = folder
       + ( (folder[ folder.length() - 1 ] == '/') ? "" : "/" );
 
+    //  
+    // (!) basename()     '/'   
+    const std::string name = fs::basename( f.substr( 0, f.length() - 1 ) );
+
     const std::string map = f + "map.js";
     assert( fs::exists( map ) && "File 'map.js' is not exists." );
-    std::ifstream fMap( f );
+    std::ifstream fMap( map.c_str() );
     std::string sMap = std::string(
         std::istreambuf_iterator< char >( fMap ),
         std::istreambuf_iterator< char >()
@@ -33,7 +45,7 @@ View View::valueOf(
     const std::string reduce = f + "reduce.js";
     std::string sReduce = "";
     if ( fs::exists( reduce ) ) {
-        std::ifstream fReduce( f );
+        std::ifstream fReduce( reduce.c_str() );
         sReduce = std::string(
             std::istreambuf_iterator< char >( fReduce ),
             std::istreambuf_iterator< char >()
@@ -42,9 +54,15 @@ View View::valueOf(
 
     //    
     if ( !context.empty() ) {
+        /* - . . .
         template_t t;
         sMap = t.render( sMap, context );
-        sReduce = t.render( sReduce, context );
+        */
+        //  -   :      
+        sMap = templates.get_string( sMap )->render( context );
+        if ( !sReduce.empty() ) {
+            sReduce = templates.get_string( sReduce )->render( context );
+        }
     }
 
     return View( name, sMap, sReduce );
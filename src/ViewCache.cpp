@@ -0,0 +1,180 @@
+#include "../include/ViewCache.h"
+#include "../include/Exception.h"
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+
+using namespace CouchFine;
+
+
+namespace {
+
+/**
+*     , .    .
+*/
+const size_t CANCEL_POLL = 20;
+
+} // namespace
+
+
+
+
+ViewCache::ViewCache( size_t capacity ) :
+    capacity( std::max( capacity, static_cast< size_t >( 1 ) ) )
+{
+}
+
+
+
+
+Object ViewCache::get( const std::string& key, fnFetch_t fetch, const Deadline& deadline ) {
+
+    boost::mutex::scoped_lock  lock( mutex );
+
+    //    :  ,     
+    for (auto ftr = flights.find( key ); ftr != flights.cend(); ftr = flights.find( key )) {
+        const std::shared_ptr< Flight >  flight = ftr->second;
+        ++counters.collapsed;
+        while ( !flight->done ) {
+            if ( deadline.cancelled() ) {
+                throw Exception( "Operation cancelled: " + key );
+            }
+            if ( deadline.expired() ) {
+                throw Exception( "Deadline exceeded: " + key );
+            }
+            const size_t ms = std::min( deadline.remaining( CANCEL_POLL ), CANCEL_POLL );
+            landed.wait_for( lock, boost::chrono::milliseconds( ms ) );
+        }
+        if ( flight->result ) {
+            //      :   
+            const std::shared_ptr< const Object >  result = flight->result;
+            lock.unlock();
+            return deepCopy( *result );
+        }
+        if ( !flight->expired ) {
+            throw Exception( flight->error );
+        }
+        //   -  :  
+    }
+
+    //  .     :  
+    // ,   .
+    const std::shared_ptr< Flight >  flight( new Flight() );
+    flights[ key ] = flight;
+    std::string etag;
+    std::shared_ptr< const Object >  cached;
+    const auto etr = entries.find( key );
+    if (etr != entries.cend()) {
+        etag = etr->second.etag;
+        cached = etr->second.result;
+    }
+    lock.unlock();
+
+    std::string newETag;
+    std::shared_ptr< Object >  result( new Object() );
+    bool modified = true;
+    std::string error;
+    try {
+        modified = fetch( cached ? etag : "", newETag, *result );
+        if ( !modified && !cached ) {
+            error = "View cache: not modified, but nothing cached for '" + key + "'.";
+        }
+    } catch ( const Exception& ex ) {
+        error = ex.what();
+    } catch ( const std::exception& ex ) {
+        error = ex.what();
+    } catch ( ... ) {
+        error = "View cache: fetch failed for '" + key + "'.";
+    }
+    if ( error.empty() && !modified ) {
+        result.reset();
+    }
+
+    lock.lock();
+    if ( error.empty() ) {
+        if ( modified ) {
+            ++counters.fetched;
+        } else {
+            ++counters.revalidated;
+        }
+        flight->result = modified ? result : cached;
+
+        //  ,  -     
+        const auto itr = entries.find( key );
+        if (itr == entries.end()) {
+            lru.push_front( key );
+            Entry& e = entries[ key ];
+            e.lru = lru.begin();
+            e.etag = newETag;
+            e.result = flight->result;
+        } else {
+            lru.splice( lru.begin(), lru, itr->second.lru );
+            if ( modified ) {
+                itr->second.etag = newETag;
+                itr->second.result = flight->result;
+            }
+        }
+        //  ETag     :  
+        if ( modified && newETag.empty() ) {
+            entries.erase( key );
+            lru.pop_front();
+        }
+        while (entries.size() > capacity) {
+            entries.erase( lru.back() );
+            lru.pop_back();
+            ++counters.evicted;
+        }
+
+    } else {
+        flight->error = error;
+        flight->expired = deadline.over();
+    }
+    flight->done = true;
+    flights.erase( key );
+    landed.notify_all();
+    lock.unlock();
+
+    if ( !flight->result ) {
+        throw Exception( error );
+    }
+    return deepCopy( *flight->result );
+}
+
+
+
+
+void ViewCache::clear() {
+    boost::mutex::scoped_lock  lock( mutex );
+    entries.clear();
+    lru.clear();
+}
+
+
+
+
+size_t ViewCache::size() const {
+    boost::mutex::scoped_lock  lock( mutex );
+    return entries.size();
+}
+
+
+
+
+ViewCache::Stats ViewCache::stats() const {
+    boost::mutex::scoped_lock  lock( mutex );
+    return counters;
+}
+
+
+
+
+std::string ViewCache::normalizeQuery( const std::string& query ) {
+    std::vector< std::string >  params;
+    boost::split( params, query, boost::is_any_of( "&" ) );
+    params.erase(
+        std::remove( params.begin(), params.end(), std::string() ),
+        params.end()
+    );
+    std::sort( params.begin(), params.end() );
+    return boost::join( params, "&" );
+}